@@ -28,6 +28,10 @@ function(myproject_setup_dependencies)
     cpmaddpackage("gh:catchorg/Catch2@3.3.2")
   endif()
 
+  if(myproject_BUILD_BENCHMARKS AND NOT TARGET nanobench)
+    cpmaddpackage("gh:martinus/nanobench@4.3.11")
+  endif()
+
   if(NOT TARGET tools::tools)
     cpmaddpackage("gh:lefticus/tools#update_build_system")
   endif()
@@ -44,5 +48,5 @@ function(myproject_setup_dependencies)
       "GLFW_BUILD_EXAMPLES OFF"
       "GLFW_BUILD_DOCS OFF")
   endif()
-  find_package(OpenGL REQUIRED)
+  find_package(OpenGL REQUIRED OPTIONAL_COMPONENTS EGL)
 endfunction()
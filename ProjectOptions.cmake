@@ -86,6 +86,7 @@ macro(myproject_setup_options)
   endif()
 
   option(myproject_BUILD_FUZZ_TESTS "Enable fuzz testing executable" ${DEFAULT_FUZZER})
+  option(myproject_BUILD_BENCHMARKS "Build the shape_bench benchmark executable" OFF)
 
 endmacro()
 
@@ -0,0 +1,254 @@
+#include <glad/glad.h>   //
+                         //
+#include <GLFW/glfw3.h>  //
+#include <nanobench.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <shape/Color.hpp>
+#include <shape/ColorKernels.hpp>
+#include <shape/Drawer.hpp>
+#include <shape/HeadlessContext.hpp>
+#include <shape/Point.hpp>
+#include <shape/QuadBatch.hpp>
+#include <shape/RenderQueue.hpp>
+#include <shape/Vector.hpp>
+#include <shape/VectorKernels.hpp>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Benchmarks of the rendering hot paths. With a directory argument every group
+// is also written there as nanobench JSON, so results can be kept per commit
+// and compared over time:
+//   shape_bench bench_results/
+namespace {
+
+using ankerl::nanobench::Bench;
+using ankerl::nanobench::doNotOptimizeAway;
+
+constexpr auto kVectors = 4096UZ;
+constexpr auto kColors = 65536UZ;
+constexpr auto kQuadCounts = std::array{100UZ, 1000UZ, 10000UZ};
+
+constexpr auto kIsaNames =
+    std::array<std::string_view, 4>{"scalar", "sse2", "avx2", "avx512"};
+
+// Runs body once for every instruction set this CPU supports.
+template <typename Body>
+void ForEachIsa(Body&& body) {
+  gl::ForEachIsa([&body](gl::Isa isa) {
+    body(kIsaNames[static_cast<std::size_t>(isa)]);
+  });
+}
+
+void Write(Bench const& group, std::filesystem::path const& directory,
+           std::string_view name) {
+  if (directory.empty()) {
+    return;
+  }
+  std::ofstream Out{directory / std::format("{}.json", name)};
+  ankerl::nanobench::render(ankerl::nanobench::templates::json(), group, Out);
+}
+
+auto MakeQuad(std::size_t index) -> std::array<gl::Point, 4> {
+  auto const X = -1.0F + (static_cast<float>(index % 100) * 0.02F);
+  auto const Y = -1.0F + (static_cast<float>(index / 100 % 100) * 0.02F);
+  auto const Color = gl::ColorFloat{.red = {static_cast<float>(index % 7) / 7},
+                                    .blue = {0.5F},
+                                    .green = {0.25F}};
+  return {gl::Point{.m_Position{{X, Y, 0.0F}}, .m_Color = Color},
+          gl::Point{.m_Position{{X + 0.02F, Y, 0.0F}}, .m_Color = Color},
+          gl::Point{.m_Position{{X + 0.02F, Y + 0.02F, 0.0F}}, .m_Color = Color},
+          gl::Point{.m_Position{{X, Y + 0.02F, 0.0F}}, .m_Color = Color}};
+}
+
+void VectorBench(std::filesystem::path const& output) {
+  std::vector<gl::Vector3<float>> Lhs(kVectors);
+  std::vector<gl::Vector3<float>> Rhs(kVectors);
+  std::vector<gl::Vector3<float>> Out(kVectors);
+  for (auto It = 0UZ; It < kVectors; ++It) {
+    auto const Value = static_cast<float>(It);
+    Lhs[It] = gl::Vector3<float>{{Value, Value * 0.5F, 1.0F}};
+    Rhs[It] = gl::Vector3<float>{{1.0F, -Value, Value * 0.25F}};
+  }
+  Bench Group;
+  Group.title("gl::Vector").unit("vector").batch(kVectors).relative(true);
+  Group.run("operator+", [&] {
+    for (auto It = 0UZ; It < kVectors; ++It) {
+      Out[It] = Lhs[It] + Rhs[It];
+    }
+    doNotOptimizeAway(Out.data());
+  });
+  Group.run("Dot", [&] {
+    auto Sum = 0.0F;
+    for (auto It = 0UZ; It < kVectors; ++It) {
+      Sum += gl::Dot(Lhs[It], Rhs[It]);
+    }
+    doNotOptimizeAway(Sum);
+  });
+  Group.run("Cross", [&] {
+    for (auto It = 0UZ; It < kVectors; ++It) {
+      Out[It] = gl::Cross(Lhs[It], Rhs[It]);
+    }
+    doNotOptimizeAway(Out.data());
+  });
+  auto const Offset = gl::Vector3<float>{{0.5F, -0.5F, 0.0F}};
+  ForEachIsa([&](std::string_view isa) {
+    Group.run(std::format("AddInPlace {}", isa), [&] {
+      gl::AddInPlace(std::span(Out), Offset);
+      doNotOptimizeAway(Out.data());
+    });
+  });
+  Write(Group, output, "vector");
+}
+
+void ColorBench(std::filesystem::path const& output) {
+  std::vector<gl::ColorInt> Ints(kColors);
+  std::vector<gl::ColorFloat> Floats(kColors);
+  std::vector<std::uint32_t> Words(kColors);
+  for (auto It = 0UZ; It < kColors; ++It) {
+    Ints[It] = gl::UnpackRgba(static_cast<std::uint32_t>(It * 2654435761U));
+  }
+  gl::ToColorFloat(Ints, Floats);
+  Bench Group;
+  Group.title("Color conversion").unit("color").batch(kColors).relative(true);
+  ForEachIsa([&](std::string_view isa) {
+    Group.run(std::format("ToColorFloat {}", isa), [&] {
+      gl::ToColorFloat(Ints, Floats);
+      doNotOptimizeAway(Floats.data());
+    });
+    Group.run(std::format("ToColorInt {}", isa), [&] {
+      gl::ToColorInt(Floats, Ints);
+      doNotOptimizeAway(Ints.data());
+    });
+    Group.run(std::format("PackRgba {}", isa), [&] {
+      gl::PackRgba(std::span<gl::ColorFloat const>(Floats), Words);
+      doNotOptimizeAway(Words.data());
+    });
+  });
+  Group.run("SrgbToLinear", [&] {
+    gl::SrgbToLinear(Ints, Floats);
+    doNotOptimizeAway(Floats.data());
+  });
+  Group.run("LinearToSrgb", [&] {
+    gl::LinearToSrgb(Floats, Ints);
+    doNotOptimizeAway(Ints.data());
+  });
+  Write(Group, output, "color");
+}
+
+void DrawerBench(std::filesystem::path const& output) {
+  auto Calls = 0ULL;
+  auto Count = [&Calls](GLFWwindow const& /*window*/,
+                        std::chrono::nanoseconds /*deltaTime*/) { ++Calls; };
+  gl::DrawerClass Drawer{Count};
+  std::function<void(GLFWwindow const&, std::chrono::nanoseconds)> Function{
+      Count};
+  // the drawers never look at the window, any address will do
+  // NOLINTNEXTLINE
+  auto const& Window = *reinterpret_cast<GLFWwindow const*>(&Calls);
+  constexpr auto kDeltaTime = std::chrono::nanoseconds{16'666'667};
+  Bench Group;
+  Group.title("Drawer dispatch").unit("call").relative(true);
+  Group.run("lambda", [&] { Count(Window, kDeltaTime); });
+  Group.run("std::function", [&] { Function(Window, kDeltaTime); });
+  Group.run("DrawerClass::Draw", [&] { Drawer.Draw(Window, kDeltaTime); });
+  doNotOptimizeAway(Calls);
+  Write(Group, output, "drawer");
+}
+
+#ifdef SHAPE_HAS_HEADLESS_CONTEXT
+// Building and updating batches, without drawing them.
+void BatchBench(std::filesystem::path const& output) {
+  Bench Group;
+  Group.title("Quad batch").unit("quad");
+  gl::RenderQueue Queue;
+  for (auto const Quads : kQuadCounts) {
+    Group.batch(Quads);
+    Group.run(std::format("build {}", Quads), [&] {
+      gl::QuadBatch Batch;
+      for (auto It = 0UZ; It < Quads; ++It) {
+        Batch.Add(MakeQuad(It));
+      }
+      Batch.Enqueue(Queue);
+      Queue.Clear();
+    });
+    gl::QuadBatch Batch;
+    std::vector<gl::QuadBatch::Handle> Handles;
+    for (auto It = 0UZ; It < Quads; ++It) {
+      Handles.push_back(Batch.Add(MakeQuad(It)));
+    }
+    auto Step = 0.0F;
+    Group.run(std::format("move {}", Quads), [&] {
+      Step += 0.001F;
+      for (auto const& Handle : Handles) {
+        Batch.SetOffset(Handle, gl::Vector4<float>{{Step, 0.0F, 0.0F, 0.0F}});
+      }
+      Batch.Enqueue(Queue);
+      Queue.Clear();
+    });
+  }
+  glFinish();
+  Write(Group, output, "batch");
+}
+
+// Whole frames: move every quad, sort and draw them, wait for the GPU.
+void FrameBench(std::filesystem::path const& output) {
+  Bench Group;
+  Group.title("Frame").unit("frame").relative(true);
+  gl::RenderQueue Queue;
+  for (auto const Quads : kQuadCounts) {
+    gl::QuadBatch Batch;
+    std::vector<gl::QuadBatch::Handle> Handles;
+    for (auto It = 0UZ; It < Quads; ++It) {
+      Handles.push_back(Batch.Add(MakeQuad(It)));
+    }
+    auto Step = 0.0F;
+    Group.run(std::format("{} quads", Quads), [&] {
+      Step += 0.001F;
+      for (auto const& Handle : Handles) {
+        Batch.SetOffset(Handle, gl::Vector4<float>{{0.0F, Step, 0.0F, 0.0F}});
+      }
+      glClear(GL_COLOR_BUFFER_BIT);
+      Batch.Enqueue(Queue);
+      Queue.Flush();
+      glFinish();
+    });
+  }
+  Write(Group, output, "frame");
+}
+#endif
+
+}  // namespace
+
+auto main(int argc, char const* argv[]) -> int {
+  auto const Arguments = std::span(argv, static_cast<std::size_t>(argc));
+  auto const Output = Arguments.size() > 1 ? std::filesystem::path{Arguments[1]}
+                                           : std::filesystem::path{};
+  VectorBench(Output);
+  ColorBench(Output);
+  DrawerBench(Output);
+#ifdef SHAPE_HAS_HEADLESS_CONTEXT
+  constexpr auto kFramebufferSize = 512;
+  auto Context =
+      gl::HeadlessContext::Create(kFramebufferSize, kFramebufferSize);
+  if (!Context) {
+    Context.error().Handle();
+    spdlog::warn("Skipping the GL benchmarks");
+    return 0;
+  }
+  BatchBench(Output);
+  FrameBench(Output);
+#else
+  spdlog::warn("Built without EGL, skipping the GL benchmarks");
+#endif
+  return 0;
+}
@@ -3,7 +3,10 @@
 #include <glad/glad.h>
 
 #include <array>
+#include <cstddef>
 #include <ranges>
+#include <shape/FrameStats.hpp>
+#include <shape/StateCache.hpp>
 
 namespace gl {
 
@@ -41,41 +44,118 @@ inline auto GenBuffer() -> GLuint {
   glGenBuffers(1, &RetVal);
   return RetVal;
 }
+// Unlike GenBuffer the object exists immediately, so the glNamedBuffer*
+// functions can be used on it without binding it first.
+inline auto CreateBuffer() -> GLuint {
+  GLuint RetVal = 0;
+  glCreateBuffers(1, &RetVal);
+  return RetVal;
+}
+// NOLINTNEXTLINE
+enum struct StorageFlags : GLbitfield {
+  kNone = 0,
+  kDynamicStorage = GL_DYNAMIC_STORAGE_BIT,
+  kMapRead = GL_MAP_READ_BIT,
+  kMapWrite = GL_MAP_WRITE_BIT,
+  kMapPersistent = GL_MAP_PERSISTENT_BIT,
+  kMapCoherent = GL_MAP_COHERENT_BIT,
+  kClientStorage = GL_CLIENT_STORAGE_BIT
+};
+constexpr auto operator|(StorageFlags lhs, StorageFlags rhs) -> StorageFlags {
+  return static_cast<StorageFlags>(static_cast<GLbitfield>(lhs) |
+                                   static_cast<GLbitfield>(rhs));
+}
+template <std::ranges::contiguous_range Range>
+constexpr auto ByteSize(Range const &range) -> std::size_t {
+  return std::size(range) * sizeof(std::ranges::range_value_t<Range>);
+}
 template <std::ranges::contiguous_range Range>
 void BufferData(BufferType type, Range const &range, Usage usage) {
-  glBufferData(
-      static_cast<GLenum>(type),
-      static_cast<GLsizeiptr>(std::size(range) *
-                              sizeof(std::ranges::range_value_t<Range>)),
-      std::begin(range), static_cast<GLenum>(usage));
+  FrameStats::Instance().CountUpload(ByteSize(range));
+  glBufferData(static_cast<GLenum>(type),
+               static_cast<GLsizeiptr>(ByteSize(range)), std::data(range),
+               static_cast<GLenum>(usage));
 }
+template <std::ranges::contiguous_range Range>
+void BufferSubData(BufferType type, std::size_t firstElement,
+                   Range const &range) {
+  using ValueType = std::ranges::range_value_t<Range>;
+  FrameStats::Instance().CountUpload(ByteSize(range));
+  glBufferSubData(static_cast<GLenum>(type),
+                  static_cast<GLintptr>(firstElement * sizeof(ValueType)),
+                  static_cast<GLsizeiptr>(ByteSize(range)), std::data(range));
+}
+// Bind() and BufferData() edit through the binding point; the Data,
+// SubData, Allocate and Storage members use direct state access and leave
+// every binding untouched.
 template <BufferType Type>
 class Buffer {
   GLuint m_id;
 
  public:
-  Buffer() : m_id{GenBuffer()} {}
+  Buffer() : m_id{CreateBuffer()} {}
 
-  auto Bind() -> void { glBindBuffer(static_cast<GLenum>(Type), m_id); }
+  auto Bind() -> void {
+    StateCache::Instance().BindBuffer(static_cast<GLenum>(Type), m_id);
+  }
   template <std::ranges::contiguous_range Range>
   void BufferData(BufferType type, Range const &range, Usage usage) {
-    glBufferData(
-        static_cast<GLenum>(type),
-        static_cast<GLsizeiptr>(std::size(range) *
-                                sizeof(std::ranges::range_value_t<Range>)),
-        std::begin(range), static_cast<GLenum>(usage));
+    gl::BufferData(type, range, usage);
   }
 
   template <std::ranges::contiguous_range Range>
-  Buffer(Range const &range, Usage usage) : m_id{GenBuffer()} {
-    BufferData(Type, range, usage);
+  Buffer(Range const &range, Usage usage) : m_id{CreateBuffer()} {
+    Data(range, usage);
+  }
+
+  template <std::ranges::contiguous_range Range>
+  void Data(Range const &range, Usage usage) {
+    FrameStats::Instance().CountUpload(ByteSize(range));
+    glNamedBufferData(m_id, static_cast<GLsizeiptr>(ByteSize(range)),
+                      std::data(range), static_cast<GLenum>(usage));
+  }
+  // (Re)allocates uninitialised mutable storage; counts as an upload of no
+  // bytes.
+  void Allocate(std::size_t bytes, Usage usage) {
+    FrameStats::Instance().CountUpload(0);
+    glNamedBufferData(m_id, static_cast<GLsizeiptr>(bytes), nullptr,
+                      static_cast<GLenum>(usage));
+  }
+  template <std::ranges::contiguous_range Range>
+  void SubData(std::size_t firstElement, Range const &range) {
+    using ValueType = std::ranges::range_value_t<Range>;
+    FrameStats::Instance().CountUpload(ByteSize(range));
+    glNamedBufferSubData(
+        m_id, static_cast<GLintptr>(firstElement * sizeof(ValueType)),
+        static_cast<GLsizeiptr>(ByteSize(range)), std::data(range));
+  }
+  // Immutable storage; may only be specified once per buffer.
+  template <std::ranges::contiguous_range Range>
+  void Storage(Range const &range, StorageFlags flags = StorageFlags::kNone) {
+    FrameStats::Instance().CountUpload(ByteSize(range));
+    glNamedBufferStorage(m_id, static_cast<GLsizeiptr>(ByteSize(range)),
+                         std::data(range), static_cast<GLbitfield>(flags));
   }
 
   Buffer(Buffer const &) = delete;
   auto operator=(Buffer const &) -> Buffer & = delete;
-  Buffer(Buffer &&) = delete;
-  auto operator=(Buffer &&) -> Buffer & = delete;
-  ~Buffer() { glDeleteBuffers(1, &m_id); }
+  Buffer(Buffer &&other) noexcept : m_id{other.m_id} { other.m_id = 0; }
+  auto operator=(Buffer &&other) noexcept -> Buffer & {
+    if (m_id != 0) {
+      StateCache::Instance().ForgetBuffer(m_id);
+      glDeleteBuffers(1, &m_id);
+    }
+    m_id = other.m_id;
+    other.m_id = 0;
+    return *this;
+  }
+  [[nodiscard]] auto Get() const noexcept -> GLuint { return m_id; }
+  ~Buffer() {
+    if (m_id != 0) {
+      StateCache::Instance().ForgetBuffer(m_id);
+      glDeleteBuffers(1, &m_id);
+    }
+  }
 };
 
 }  // namespace gl
@@ -22,7 +22,8 @@ struct ColorFloat {
   GreenFloat green{0.0F};
   AlphaFloat alpha{1.0F};
 };
-constexpr auto kColorRange = 256UZ;
+// largest channel value, it maps to 1.0
+constexpr auto kColorRange = 255UZ;
 struct AlphaInt {
   uint8_t val;
   explicit operator AlphaFloat() const {
@@ -0,0 +1,322 @@
+#ifndef SHAPE_COLORKERNELS_HPP
+#define SHAPE_COLORKERNELS_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <shape/Color.hpp>
+#include <shape/VectorKernels.hpp>
+#include <span>
+#include <stdexcept>
+namespace gl {
+
+// Bulk conversions between ColorInt, ColorFloat and packed 32-bit RGBA for
+// palettes and texture data. Unorm conversions are exact: a channel c maps to
+// the float nearest to c / 255, and floats go back to the nearest of the 256
+// levels. Channel order of ColorInt and ColorFloat is red, blue, green,
+// alpha; packed RGBA is what GL_RGBA / GL_UNSIGNED_BYTE reads, red in the
+// lowest byte.
+
+static_assert(sizeof(ColorInt) == 4 && sizeof(ColorFloat) == 16);
+
+// NaN packs to 0, like the SSE min/max clamps.
+inline auto ToUnorm8(float value) -> std::uint8_t {
+  auto const Clamped = value > 0.0F ? std::min(value, 1.0F) : 0.0F;
+  return static_cast<std::uint8_t>(std::nearbyint(Clamped * 255.0F));
+}
+inline auto ToColorInt(ColorFloat const& color) -> ColorInt {
+  return {.red = {ToUnorm8(color.red.val)},
+          .blue = {ToUnorm8(color.blue.val)},
+          .green = {ToUnorm8(color.green.val)},
+          .alpha = {ToUnorm8(color.alpha.val)}};
+}
+constexpr auto PackRgba(ColorInt color) -> std::uint32_t {
+  return static_cast<std::uint32_t>(color.red.val) |
+         (static_cast<std::uint32_t>(color.green.val) << 8U) |
+         (static_cast<std::uint32_t>(color.blue.val) << 16U) |
+         (static_cast<std::uint32_t>(color.alpha.val) << 24U);
+}
+constexpr auto UnpackRgba(std::uint32_t rgba) -> ColorInt {
+  return {.red = {static_cast<std::uint8_t>(rgba)},
+          .blue = {static_cast<std::uint8_t>(rgba >> 16U)},
+          .green = {static_cast<std::uint8_t>(rgba >> 8U)},
+          .alpha = {static_cast<std::uint8_t>(rgba >> 24U)}};
+}
+
+// sRGB transfer function of one 8-bit channel, through a 256 entry table.
+inline auto SrgbToLinear(std::uint8_t value) -> float {
+  static auto const kTable = [] {
+    std::array<float, 256> Table{};
+    for (auto It = 0UZ; It < Table.size(); ++It) {
+      auto const Encoded = static_cast<double>(It) / 255.0;
+      Table.at(It) = static_cast<float>(
+          Encoded <= 0.04045 ? Encoded / 12.92
+                             : std::pow((Encoded + 0.055) / 1.055, 2.4));
+    }
+    return Table;
+  }();
+  return kTable.at(value);
+}
+// Inverse of SrgbToLinear, rounded to the nearest 8-bit level: a branchless
+// binary search over the linear values halfway between two levels.
+inline auto LinearToSrgb(float value) -> std::uint8_t {
+  static auto const kThresholds = [] {
+    std::array<float, 256> Table{};
+    for (auto It = 0UZ; It + 1 < Table.size(); ++It) {
+      auto const Encoded = (static_cast<double>(It) + 0.5) / 255.0;
+      Table.at(It) = static_cast<float>(
+          Encoded <= 0.04045 ? Encoded / 12.92
+                             : std::pow((Encoded + 0.055) / 1.055, 2.4));
+    }
+    Table.back() = std::numeric_limits<float>::infinity();
+    return Table;
+  }();
+  auto Level = 0U;
+  for (auto Step = 128U; Step > 0; Step >>= 1U) {
+    Level += value >= kThresholds.at(Level + Step - 1) ? Step : 0U;
+  }
+  return static_cast<std::uint8_t>(Level);
+}
+
+namespace kernels {
+
+// Swaps bytes 1 and 2 of every 32-bit word, i.e. turns red, blue, green,
+// alpha into red, green, blue, alpha and back.
+constexpr auto SwapBlueGreen(std::uint32_t word) -> std::uint32_t {
+  return (word & 0xFF0000FFU) | ((word & 0x0000FF00U) << 8U) |
+         ((word & 0x00FF0000U) >> 8U);
+}
+
+template <bool kSwap>
+inline void UnormToFloatScalar(std::span<std::uint32_t const> colors,
+                               std::span<float> out) {
+  for (auto It = 0UZ; It < colors.size(); ++It) {
+    std::uint32_t Word{};
+    std::memcpy(&Word, &colors[It], sizeof(Word));
+    Word = kSwap ? SwapBlueGreen(Word) : Word;
+    for (auto Channel = 0U; Channel < 4; ++Channel) {
+      out[(It * 4) + Channel] =
+          static_cast<float>((Word >> (Channel * 8U)) & 0xFFU) / 255.0F;
+    }
+  }
+}
+template <bool kSwap>
+inline void FloatToUnormScalar(std::span<float const> channels,
+                               std::span<std::uint32_t> out) {
+  for (auto It = 0UZ; It < out.size(); ++It) {
+    std::uint32_t Word{};
+    for (auto Channel = 0U; Channel < 4; ++Channel) {
+      Word |= static_cast<std::uint32_t>(ToUnorm8(channels[(It * 4) + Channel]))
+              << (Channel * 8U);
+    }
+    Word = kSwap ? SwapBlueGreen(Word) : Word;
+    std::memcpy(&out[It], &Word, sizeof(Word));
+  }
+}
+
+#ifdef SHAPE_KERNEL_DISPATCH
+template <bool kSwap>
+SHAPE_TARGET("sse2")
+inline auto SwapBlueGreenSse2(__m128i words) -> __m128i {
+  if constexpr (kSwap) {
+    auto const Keep =
+        _mm_and_si128(words, _mm_set1_epi32(static_cast<int>(0xFF0000FFU)));
+    auto const Blue = _mm_and_si128(words, _mm_set1_epi32(0x0000FF00));
+    auto const Green = _mm_and_si128(words, _mm_set1_epi32(0x00FF0000));
+    return _mm_or_si128(
+        Keep, _mm_or_si128(_mm_slli_epi32(Blue, 8), _mm_srli_epi32(Green, 8)));
+  }
+  return words;
+}
+template <bool kSwap>
+SHAPE_TARGET("sse2")
+inline void UnormToFloatSse2(std::span<std::uint32_t const> colors,
+                             std::span<float> out) {
+  auto const Range = _mm_set1_ps(255.0F);
+  auto const Zero = _mm_setzero_si128();
+  auto It = 0UZ;
+  for (; It + 4 <= colors.size(); It += 4) {
+    auto const Bytes = SwapBlueGreenSse2<kSwap>(_mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(&colors[It])));  // NOLINT
+    auto const Low = _mm_unpacklo_epi8(Bytes, Zero);
+    auto const High = _mm_unpackhi_epi8(Bytes, Zero);
+    __m128i const Words[4] = {_mm_unpacklo_epi16(Low, Zero),  // NOLINT
+                              _mm_unpackhi_epi16(Low, Zero),
+                              _mm_unpacklo_epi16(High, Zero),
+                              _mm_unpackhi_epi16(High, Zero)};
+    for (auto Color = 0UZ; Color < 4; ++Color) {
+      // a true division, multiplying by 1/255 is off by one ulp for some c
+      _mm_storeu_ps(&out[(It + Color) * 4],
+                    _mm_div_ps(_mm_cvtepi32_ps(Words[Color]), Range));
+    }
+  }
+  UnormToFloatScalar<kSwap>(colors.subspan(It), out.subspan(It * 4));
+}
+template <bool kSwap>
+SHAPE_TARGET("avx2")
+inline void UnormToFloatAvx2(std::span<std::uint32_t const> colors,
+                             std::span<float> out) {
+  auto const Range = _mm256_set1_ps(255.0F);
+  auto It = 0UZ;
+  for (; It + 4 <= colors.size(); It += 4) {
+    auto const Bytes = SwapBlueGreenSse2<kSwap>(_mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(&colors[It])));  // NOLINT
+    auto const First = _mm256_cvtepu8_epi32(Bytes);
+    auto const Second = _mm256_cvtepu8_epi32(_mm_srli_si128(Bytes, 8));
+    _mm256_storeu_ps(&out[It * 4],
+                     _mm256_div_ps(_mm256_cvtepi32_ps(First), Range));
+    _mm256_storeu_ps(&out[(It + 2) * 4],
+                     _mm256_div_ps(_mm256_cvtepi32_ps(Second), Range));
+  }
+  UnormToFloatScalar<kSwap>(colors.subspan(It), out.subspan(It * 4));
+}
+SHAPE_TARGET("sse2")
+inline auto QuantizeSse2(float const* channels) -> __m128i {
+  auto const Value = _mm_loadu_ps(channels);
+  // max first, it returns its second operand for NaN lanes
+  auto const Clamped =
+      _mm_min_ps(_mm_max_ps(Value, _mm_setzero_ps()), _mm_set1_ps(1.0F));
+  return _mm_cvtps_epi32(_mm_mul_ps(Clamped, _mm_set1_ps(255.0F)));
+}
+template <bool kSwap>
+SHAPE_TARGET("sse2")
+inline void FloatToUnormSse2(std::span<float const> channels,
+                             std::span<std::uint32_t> out) {
+  auto It = 0UZ;
+  for (; It + 4 <= out.size(); It += 4) {
+    auto const* Color = &channels[It * 4];
+    auto const Low =
+        _mm_packs_epi32(QuantizeSse2(Color), QuantizeSse2(Color + 4));
+    auto const High =
+        _mm_packs_epi32(QuantizeSse2(Color + 8), QuantizeSse2(Color + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[It]),  // NOLINT
+                     SwapBlueGreenSse2<kSwap>(_mm_packus_epi16(Low, High)));
+  }
+  FloatToUnormScalar<kSwap>(channels.subspan(It * 4), out.subspan(It));
+}
+#endif
+
+template <bool kSwap>
+inline void UnormToFloat(std::span<std::uint32_t const> colors,
+                         std::span<float> out) {
+#ifdef SHAPE_KERNEL_DISPATCH
+  switch (ActiveIsa()) {
+    case Isa::kAvx512:
+    case Isa::kAvx2:
+      UnormToFloatAvx2<kSwap>(colors, out);
+      return;
+    case Isa::kSse2:
+      UnormToFloatSse2<kSwap>(colors, out);
+      return;
+    case Isa::kScalar:
+      break;
+  }
+#endif
+  UnormToFloatScalar<kSwap>(colors, out);
+}
+template <bool kSwap>
+inline void FloatToUnorm(std::span<float const> channels,
+                         std::span<std::uint32_t> out) {
+#ifdef SHAPE_KERNEL_DISPATCH
+  if (ActiveIsa() >= Isa::kSse2) {
+    FloatToUnormSse2<kSwap>(channels, out);
+    return;
+  }
+#endif
+  FloatToUnormScalar<kSwap>(channels, out);
+}
+
+inline void CheckColorSizes(std::size_t in, std::size_t out) {
+  if (in != out) {
+    throw std::invalid_argument("color conversion: spans differ in length");
+  }
+}
+// ColorInt and ColorFloat are reinterpreted as their four channels; the
+// kernels only touch ColorInt storage through memcpy and vector loads.
+inline auto Words(std::span<ColorInt const> colors)
+    -> std::span<std::uint32_t const> {
+  // NOLINTNEXTLINE
+  return {reinterpret_cast<std::uint32_t const*>(colors.data()), colors.size()};
+}
+inline auto Words(std::span<ColorInt> colors) -> std::span<std::uint32_t> {
+  // NOLINTNEXTLINE
+  return {reinterpret_cast<std::uint32_t*>(colors.data()), colors.size()};
+}
+inline auto Channels(std::span<ColorFloat const> colors)
+    -> std::span<float const> {
+  // NOLINTNEXTLINE
+  return {reinterpret_cast<float const*>(colors.data()), colors.size() * 4};
+}
+inline auto Channels(std::span<ColorFloat> colors) -> std::span<float> {
+  // NOLINTNEXTLINE
+  return {reinterpret_cast<float*>(colors.data()), colors.size() * 4};
+}
+
+}  // namespace kernels
+
+inline void ToColorFloat(std::span<ColorInt const> colors,
+                         std::span<ColorFloat> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  kernels::UnormToFloat<false>(kernels::Words(colors), kernels::Channels(out));
+}
+inline void ToColorFloat(std::span<std::uint32_t const> rgba,
+                         std::span<ColorFloat> out) {
+  kernels::CheckColorSizes(rgba.size(), out.size());
+  kernels::UnormToFloat<true>(rgba, kernels::Channels(out));
+}
+inline void ToColorInt(std::span<ColorFloat const> colors,
+                       std::span<ColorInt> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  kernels::FloatToUnorm<false>(kernels::Channels(colors), kernels::Words(out));
+}
+inline void PackRgba(std::span<ColorFloat const> colors,
+                     std::span<std::uint32_t> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  kernels::FloatToUnorm<true>(kernels::Channels(colors), out);
+}
+inline void PackRgba(std::span<ColorInt const> colors,
+                     std::span<std::uint32_t> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  std::ranges::transform(colors, out.begin(), [](ColorInt color) {
+    return kernels::SwapBlueGreen(std::bit_cast<std::uint32_t>(color));
+  });
+}
+inline void UnpackRgba(std::span<std::uint32_t const> rgba,
+                       std::span<ColorInt> out) {
+  kernels::CheckColorSizes(rgba.size(), out.size());
+  std::ranges::transform(rgba, out.begin(), [](std::uint32_t word) {
+    return std::bit_cast<ColorInt>(kernels::SwapBlueGreen(word));
+  });
+}
+
+// sRGB encoded colors to linear floats; alpha is linear and only rescaled.
+inline void SrgbToLinear(std::span<ColorInt const> colors,
+                         std::span<ColorFloat> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  for (auto It = 0UZ; It < colors.size(); ++It) {
+    auto const& Color = colors[It];
+    out[It] = {.red = {SrgbToLinear(Color.red.val)},
+               .blue = {SrgbToLinear(Color.blue.val)},
+               .green = {SrgbToLinear(Color.green.val)},
+               .alpha = static_cast<AlphaFloat>(Color.alpha)};
+  }
+}
+inline void LinearToSrgb(std::span<ColorFloat const> colors,
+                         std::span<ColorInt> out) {
+  kernels::CheckColorSizes(colors.size(), out.size());
+  for (auto It = 0UZ; It < colors.size(); ++It) {
+    auto const& Color = colors[It];
+    out[It] = {.red = {LinearToSrgb(Color.red.val)},
+               .blue = {LinearToSrgb(Color.blue.val)},
+               .green = {LinearToSrgb(Color.green.val)},
+               .alpha = {ToUnorm8(Color.alpha.val)}};
+  }
+}
+
+}  // namespace gl
+#endif
@@ -15,22 +15,34 @@ struct DrawingConcept {
   DrawingConcept(DrawingConcept&&) = default;
   auto operator=(DrawingConcept const&) -> DrawingConcept& = default;
   auto operator=(DrawingConcept&&) -> DrawingConcept& = default;
-  virtual void Draw(GLFWwindow const& window, std::chrono::nanoseconds) = 0;
+  virtual void Draw(GLFWwindow const& window, std::chrono::nanoseconds,
+                    float alpha) = 0;
   virtual ~DrawingConcept() = default;
 };
 
+// Draw functions take the window and the delta time, and optionally the
+// interpolation alpha between the last two simulation steps.
 template <typename Func>
-  requires std::is_invocable_v<Func, GLFWwindow const&,
-                               std::chrono::nanoseconds>
+concept DrawFunction =
+    std::invocable<Func, GLFWwindow const&, std::chrono::nanoseconds> ||
+    std::invocable<Func, GLFWwindow const&, std::chrono::nanoseconds, float>;
+
+template <typename Func>
+  requires DrawFunction<Func>
 class ConcreteDrawer : DrawingConcept {
   Func m_drawStrategy{};
 
  public:
   explicit ConcreteDrawer(Func function)
       : m_drawStrategy(std::move(function)) {}
-  void Draw(GLFWwindow const& window,
-            std::chrono::nanoseconds deltaTime) override {
-    m_drawStrategy(window, deltaTime);
+  void Draw(GLFWwindow const& window, std::chrono::nanoseconds deltaTime,
+            float alpha) override {
+    if constexpr (std::invocable<Func, GLFWwindow const&,
+                                 std::chrono::nanoseconds, float>) {
+      m_drawStrategy(window, deltaTime, alpha);
+    } else {
+      m_drawStrategy(window, deltaTime);
+    }
   }
 };
 constexpr std::size_t kBytesForStackDrawer{128};
@@ -41,7 +53,7 @@ class DrawerClass {
 
  public:
   template <typename Func>
-    requires std::invocable<Func, GLFWwindow const&, std::chrono::nanoseconds>
+    requires DrawFunction<Func>
   explicit DrawerClass(Func drawingFunction) {
     if constexpr (sizeof(ConcreteDrawer<Func>) <= kBytesForStackDrawer) {
       m_concreteDrawHolder = std::array<std::byte, kBytesForStackDrawer>{};
@@ -57,17 +69,19 @@ class DrawerClass {
           std::unique_ptr(ConcreteDrawer(drawingFunction)));
     }
   }
-  void Draw(GLFWwindow const& window, std::chrono::nanoseconds deltaTime) {
+  // alpha defaults to drawing the latest simulated state as it is
+  void Draw(GLFWwindow const& window, std::chrono::nanoseconds deltaTime,
+            float alpha = 1.0F) {
     if (std::holds_alternative<std::unique_ptr<DrawingConcept>>(
             m_concreteDrawHolder)) {
       std::get<std::unique_ptr<DrawingConcept>>(m_concreteDrawHolder)
-          ->Draw(window, deltaTime);
+          ->Draw(window, deltaTime, alpha);
     } else {
       // NOLINTNEXTLINE
       reinterpret_cast<DrawingConcept*>(
           &std::get<std::array<std::byte, kBytesForStackDrawer>>(
               m_concreteDrawHolder))
-          ->Draw(window, deltaTime);
+          ->Draw(window, deltaTime, alpha);
     }
   }
 };
@@ -0,0 +1,82 @@
+#ifndef SHAPE_FIXEDTIMESTEP_HPP
+#define SHAPE_FIXEDTIMESTEP_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+namespace gl {
+
+// Turns variable frame times into whole simulation steps of a fixed length.
+// Elapsed time collects in an accumulator, and every full step in it runs
+// once. The remainder becomes alpha: how far rendering is between the last
+// two simulated states. At most MaxSteps run per frame. Time beyond that is
+// dropped, so a slow frame cannot snowball into ever more steps (the spiral
+// of death). Elapsed times should come from std::chrono::steady_clock.
+class FixedTimestep {
+ public:
+  static constexpr auto kDefaultStep =
+      std::chrono::nanoseconds{std::chrono::seconds{1}} / 60;
+  static constexpr std::uint32_t kDefaultMaxSteps = 5;
+
+  struct Tick {
+    std::uint32_t m_Steps{};
+    // in [0, 1): accumulated time left over, in steps
+    float m_Alpha{};
+  };
+
+ private:
+  std::chrono::nanoseconds m_Step;
+  std::uint32_t m_MaxSteps;
+  std::chrono::nanoseconds m_Accumulator{};
+  std::chrono::nanoseconds m_Dropped{};
+
+ public:
+  explicit constexpr FixedTimestep(std::chrono::nanoseconds step = kDefaultStep,
+                                   std::uint32_t maxSteps = kDefaultMaxSteps)
+      : m_Step{std::max(step, std::chrono::nanoseconds{1})},
+        m_MaxSteps{std::max(maxSteps, 1U)} {}
+
+  // Adds elapsed to the accumulator and takes the whole steps out of it.
+  constexpr auto Advance(std::chrono::nanoseconds elapsed) -> Tick {
+    m_Accumulator += std::max(elapsed, std::chrono::nanoseconds{});
+    auto Steps = static_cast<std::uint64_t>(m_Accumulator / m_Step);
+    if (Steps > m_MaxSteps) {
+      Steps = m_MaxSteps;
+      auto const Kept = m_Step * m_MaxSteps;
+      m_Dropped += m_Accumulator - Kept;
+      m_Accumulator = Kept;
+    }
+    m_Accumulator -= m_Step * static_cast<std::int64_t>(Steps);
+    return {.m_Steps = static_cast<std::uint32_t>(Steps),
+            .m_Alpha = static_cast<float>(m_Accumulator.count()) /
+                       static_cast<float>(m_Step.count())};
+  }
+  // Advance that calls step(Step()) once per simulation step; returns alpha.
+  template <typename StepFunction>
+    requires std::invocable<StepFunction&, std::chrono::nanoseconds>
+  constexpr auto Simulate(std::chrono::nanoseconds elapsed,
+                          StepFunction&& step) -> float {
+    auto const Result = Advance(elapsed);
+    for (auto It = 0U; It < Result.m_Steps; ++It) {
+      step(m_Step);
+    }
+    return Result.m_Alpha;
+  }
+
+  [[nodiscard]] constexpr auto Step() const noexcept
+      -> std::chrono::nanoseconds {
+    return m_Step;
+  }
+  [[nodiscard]] constexpr auto MaxSteps() const noexcept -> std::uint32_t {
+    return m_MaxSteps;
+  }
+  // Total time the step limit threw away.
+  [[nodiscard]] constexpr auto Dropped() const noexcept
+      -> std::chrono::nanoseconds {
+    return m_Dropped;
+  }
+};
+
+}  // namespace gl
+#endif
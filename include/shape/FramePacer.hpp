@@ -0,0 +1,176 @@
+#ifndef SHAPE_FRAMEPACER_HPP
+#define SHAPE_FRAMEPACER_HPP
+#include <glad/glad.h>  //
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// Holds frames to a target rate. WaitForNextFrame sleeps until shortly before
+// the next frame is due, then spins through the rest, because sleeps overshoot
+// by up to a scheduler tick. The spin margin follows the overshoot that was
+// actually seen. Call it right before sampling input, so input is read as
+// late as possible before the frame it drives. A frame that starts more than
+// an interval late restarts the schedule instead of rushing to catch up.
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  struct Stats {
+    std::uint64_t m_Frames{};
+    std::uint64_t m_MissedDeadlines{};
+    std::chrono::nanoseconds m_SpinMargin{};
+  };
+
+ private:
+  static constexpr auto kMinSpinMargin = std::chrono::nanoseconds{100'000};
+  static constexpr auto kMaxSpinMargin = std::chrono::nanoseconds{4'000'000};
+  static constexpr auto kMarginDecay = 16;
+
+  std::chrono::nanoseconds m_Interval{};
+  Clock::time_point m_NextFrame{};
+  std::chrono::nanoseconds m_SpinMargin{1'000'000};
+  Stats m_Stats;
+
+  void SleepUntil(Clock::time_point deadline) {
+    auto const Wake = deadline - m_SpinMargin;
+    if (Clock::now() < Wake) {
+      std::this_thread::sleep_until(Wake);
+      // grow straight to a larger overshoot, shrink slowly after smaller ones
+      auto const Overshoot = Clock::now() - Wake;
+      m_SpinMargin =
+          Overshoot > m_SpinMargin
+              ? Overshoot
+              : m_SpinMargin - ((m_SpinMargin - Overshoot) / kMarginDecay);
+      m_SpinMargin = std::clamp(m_SpinMargin, kMinSpinMargin, kMaxSpinMargin);
+    }
+    while (Clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+  }
+
+ public:
+  // A rate of 0 leaves frames unpaced.
+  explicit FramePacer(double framesPerSecond = 0.0) {
+    SetTargetRate(framesPerSecond);
+  }
+
+  void SetTargetRate(double framesPerSecond) {
+    m_Interval = framesPerSecond > 0.0
+                     ? std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::duration<double>{1.0 / framesPerSecond})
+                     : std::chrono::nanoseconds{};
+    m_NextFrame = {};
+  }
+  // Blocks until the next frame is due.
+  void WaitForNextFrame() {
+    ++m_Stats.m_Frames;
+    if (m_Interval == std::chrono::nanoseconds{}) {
+      return;
+    }
+    auto const Now = Clock::now();
+    if (m_NextFrame == Clock::time_point{} || Now - m_NextFrame > m_Interval) {
+      if (m_NextFrame != Clock::time_point{}) {
+        ++m_Stats.m_MissedDeadlines;
+      }
+      m_NextFrame = Now;
+    } else {
+      SleepUntil(m_NextFrame);
+    }
+    m_NextFrame += m_Interval;
+  }
+
+  [[nodiscard]] auto Interval() const noexcept -> std::chrono::nanoseconds {
+    return m_Interval;
+  }
+  [[nodiscard]] auto GetStats() const noexcept -> Stats {
+    auto Current = m_Stats;
+    Current.m_SpinMargin = m_SpinMargin;
+    return Current;
+  }
+};
+
+// Limits how many frames the GPU may lag behind. EndFrame places a fence
+// behind each frame's commands, and Wait blocks until the fence of the frame
+// FramesInFlight frames back is signalled. The driver can then no longer
+// queue frames on its own, and what is on screen is never more than
+// FramesInFlight frames old. Used on the context's thread only.
+class FrameFences {
+  static constexpr GLuint64 kWaitTimeoutNs = 1'000'000;
+
+  std::vector<GLsync> m_Fences;
+  std::size_t m_Frame{};
+  std::size_t m_Stalls{};
+
+  void Release() noexcept {
+    for (auto& Fence : m_Fences) {
+      if (Fence != nullptr) {
+        glDeleteSync(Fence);
+        Fence = nullptr;
+      }
+    }
+  }
+
+ public:
+  explicit FrameFences(std::size_t framesInFlight = 2)
+      : m_Fences(std::max(framesInFlight, 1UZ), nullptr) {}
+  FrameFences(FrameFences const&) = delete;
+  auto operator=(FrameFences const&) -> FrameFences& = delete;
+  FrameFences(FrameFences&& other) noexcept
+      : m_Fences(std::move(other.m_Fences)),
+        m_Frame(other.m_Frame),
+        m_Stalls(other.m_Stalls) {}
+  auto operator=(FrameFences&& other) noexcept -> FrameFences& {
+    if (this != &other) {
+      Release();
+      m_Fences = std::move(other.m_Fences);
+      m_Frame = other.m_Frame;
+      m_Stalls = other.m_Stalls;
+    }
+    return *this;
+  }
+  ~FrameFences() { Release(); }
+
+  // Call before submitting a frame.
+  void Wait() {
+    auto& Fence = m_Fences[m_Frame % m_Fences.size()];
+    if (Fence == nullptr) {
+      return;
+    }
+    auto Status = glClientWaitSync(Fence, 0, 0);
+    if (Status != GL_ALREADY_SIGNALED && Status != GL_CONDITION_SATISFIED) {
+      ++m_Stalls;
+      while (Status == GL_TIMEOUT_EXPIRED) {
+        Status = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  kWaitTimeoutNs);
+      }
+    }
+    glDeleteSync(Fence);
+    Fence = nullptr;
+  }
+  // Call after the frame's last command, typically the buffer swap.
+  void EndFrame() {
+    auto& Fence = m_Fences[m_Frame % m_Fences.size()];
+    if (Fence != nullptr) {
+      glDeleteSync(Fence);
+    }
+    Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_Frame;
+  }
+
+  [[nodiscard]] auto FramesInFlight() const noexcept -> std::size_t {
+    return m_Fences.size();
+  }
+  // Waits that found the GPU still busy with the frame.
+  [[nodiscard]] auto Stalls() const noexcept -> std::size_t {
+    return m_Stalls;
+  }
+};
+
+}  // namespace gl
+#endif
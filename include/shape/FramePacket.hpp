@@ -0,0 +1,33 @@
+#ifndef SHAPE_FRAMEPACKET_HPP
+#define SHAPE_FRAMEPACKET_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <shape/RenderQueue.hpp>
+#include <shape/Vector.hpp>
+#include <vector>
+namespace gl {
+
+// Everything the render thread needs to draw one simulated frame. The
+// simulation fills it, the render thread only reads it.
+struct FramePacket {
+  std::uint64_t m_Frame{};
+  std::chrono::nanoseconds m_DeltaTime{};
+  // the window's framebuffer size, for the viewport
+  int m_FramebufferWidth{};
+  int m_FramebufferHeight{};
+  // in normalized device coordinates, sampled with the frame's input
+  Vector2<float> m_Cursor{{0.0F, 0.0F}};
+  // submitted to the render queue as they are
+  std::vector<DrawCommand> m_Commands;
+
+  // Keeps the capacity, so steady frames do not allocate.
+  void Reset(std::uint64_t frame, std::chrono::nanoseconds deltaTime) {
+    m_Frame = frame;
+    m_DeltaTime = deltaTime;
+    m_Commands.clear();
+  }
+};
+
+}  // namespace gl
+#endif
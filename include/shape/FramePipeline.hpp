@@ -0,0 +1,209 @@
+#ifndef SHAPE_FRAMEPIPELINE_HPP
+#define SHAPE_FRAMEPIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shape/Profiler.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+namespace gl {
+
+// Runs a frame as a chain of stages, e.g. update -> cull -> sort -> build ->
+// submit, over a ring of Depth packets. Stage i works on frame f once stage
+// i - 1 finished it, and the first stage starts frame f only once the last
+// one finished frame f - Depth, so up to Depth frames are in flight. Depth 1
+// runs the stages strictly one frame after another; every extra frame of
+// depth buys overlap for one frame of latency.
+//
+// Every stage gets the frame's packet and the delta time the first stage
+// measured for it, like DrawerClass::Draw. A stage runs either on a thread of
+// the pipeline or on a thread of the caller's choosing, which drives it with
+// RunStage; the stage issuing GL calls has to be driven by the context's
+// thread. Stage names show up as profiler scopes and must outlive the
+// profiler.
+template <typename Packet>
+class FramePipeline {
+ public:
+  using StageFunction =
+      std::move_only_function<void(Packet&, std::chrono::nanoseconds)>;
+  // NOLINTNEXTLINE
+  enum struct Runner { kCaller, kOwnThread };
+  struct StageTiming {
+    char const* m_Name{};
+    std::uint64_t m_Frames{};
+    std::chrono::nanoseconds m_Last{};
+    // exponential moving average over roughly the last 16 frames
+    std::chrono::nanoseconds m_Average{};
+  };
+
+ private:
+  static constexpr auto kClosed = 1ULL << 63U;
+  static constexpr auto kAverageWeight = 16;
+
+  struct Stage {
+    char const* m_Name{};
+    StageFunction m_Function;
+    Runner m_Runner{};
+    // frames finished by this stage, kClosed once it will not run again
+    alignas(64) std::atomic<std::uint64_t> m_Done{0};
+    std::atomic<std::int64_t> m_LastNs{0};
+    std::atomic<std::int64_t> m_AverageNs{0};
+  };
+  struct Slot {
+    Packet m_Packet{};
+    std::chrono::nanoseconds m_DeltaTime{};
+  };
+
+  std::vector<std::unique_ptr<Stage>> m_Stages;
+  std::vector<Slot> m_Slots;
+  std::vector<std::thread> m_Threads;
+  std::chrono::steady_clock::time_point m_PreviousStart;
+  bool m_Started{false};
+
+  // Blocks until stage may run frame; false once the stage before it is
+  // closed and drained.
+  auto AwaitInput(std::size_t stage, std::uint64_t frame) -> bool {
+    if (stage == 0) {
+      if ((m_Stages[0]->m_Done.load(std::memory_order_relaxed) & kClosed) !=
+          0) {
+        return false;
+      }
+      // back-pressure: at most Depth frames between first and last stage
+      auto& Last = *m_Stages.back();
+      auto Finished = Last.m_Done.load(std::memory_order_acquire);
+      while (frame - (Finished & ~kClosed) >= m_Slots.size()) {
+        Last.m_Done.wait(Finished, std::memory_order_acquire);
+        Finished = Last.m_Done.load(std::memory_order_acquire);
+      }
+      return true;
+    }
+    auto& Previous = *m_Stages[stage - 1];
+    auto State = Previous.m_Done.load(std::memory_order_acquire);
+    while ((State & ~kClosed) == frame) {
+      if ((State & kClosed) != 0) {
+        return false;
+      }
+      Previous.m_Done.wait(State, std::memory_order_acquire);
+      State = Previous.m_Done.load(std::memory_order_acquire);
+    }
+    return true;
+  }
+  static void Record(Stage& stage, std::chrono::nanoseconds duration) {
+    auto const Last = duration.count();
+    auto const Average = stage.m_AverageNs.load(std::memory_order_relaxed);
+    stage.m_LastNs.store(Last, std::memory_order_relaxed);
+    stage.m_AverageNs.store(
+        Average == 0 ? Last : Average + ((Last - Average) / kAverageWeight),
+        std::memory_order_relaxed);
+  }
+  void MarkClosed(Stage& stage) {
+    stage.m_Done.fetch_or(kClosed, std::memory_order_release);
+    stage.m_Done.notify_all();
+  }
+
+ public:
+  explicit FramePipeline(std::size_t depth = 2) : m_Slots(depth) {
+    if (depth == 0) {
+      throw std::invalid_argument("FramePipeline: depth must be at least 1");
+    }
+  }
+  FramePipeline(FramePipeline const&) = delete;
+  auto operator=(FramePipeline const&) -> FramePipeline& = delete;
+  FramePipeline(FramePipeline&&) = delete;
+  auto operator=(FramePipeline&&) -> FramePipeline& = delete;
+  // Closes the pipeline and joins its threads; stages run by callers must
+  // keep running until RunStage returns false.
+  ~FramePipeline() {
+    if (!m_Stages.empty()) {
+      Close();
+    }
+    for (auto& Thread : m_Threads) {
+      Thread.join();
+    }
+  }
+
+  // Stages run in the order they are added; all of them before Start.
+  auto AddStage(char const* name, StageFunction function,
+                Runner runner = Runner::kOwnThread) -> std::size_t {
+    if (m_Started) {
+      throw std::logic_error("FramePipeline: stages are added before Start");
+    }
+    auto& Added = *m_Stages.emplace_back(std::make_unique<Stage>());
+    Added.m_Name = name;
+    Added.m_Function = std::move(function);
+    Added.m_Runner = runner;
+    return m_Stages.size() - 1;
+  }
+  // Starts the threads of the kOwnThread stages.
+  void Start() {
+    m_Started = true;
+    m_PreviousStart = std::chrono::steady_clock::now();
+    for (auto It = 0UZ; It < m_Stages.size(); ++It) {
+      if (m_Stages[It]->m_Runner == Runner::kOwnThread) {
+        m_Threads.emplace_back([this, It] {
+          while (RunStage(It)) {
+          }
+        });
+      }
+    }
+  }
+  // Runs stage on its next frame, waiting for input and back-pressure first.
+  // Returns false, without running it, once the pipeline is closed and the
+  // stage has seen every frame.
+  auto RunStage(std::size_t stage) -> bool {
+    auto& Current = *m_Stages.at(stage);
+    auto const Frame =
+        Current.m_Done.load(std::memory_order_relaxed) & ~kClosed;
+    if (!AwaitInput(stage, Frame)) {
+      if (stage != 0) {
+        MarkClosed(Current);
+      }
+      return false;
+    }
+    auto& Target = m_Slots[Frame % m_Slots.size()];
+    auto const Start = std::chrono::steady_clock::now();
+    if (stage == 0) {
+      Target.m_DeltaTime =
+          Frame == 0 ? std::chrono::nanoseconds{} : Start - m_PreviousStart;
+      m_PreviousStart = Start;
+    }
+    {
+      CpuScope const Scope{Current.m_Name};
+      Current.m_Function(Target.m_Packet, Target.m_DeltaTime);
+    }
+    Record(Current, std::chrono::steady_clock::now() - Start);
+    Current.m_Done.fetch_add(1, std::memory_order_release);
+    Current.m_Done.notify_all();
+    return true;
+  }
+  // Called by the thread driving the first stage once it produced its last
+  // frame; the later stages drain the frames in flight and stop.
+  void Close() { MarkClosed(*m_Stages.front()); }
+
+  [[nodiscard]] auto Depth() const noexcept -> std::size_t {
+    return m_Slots.size();
+  }
+  [[nodiscard]] auto StageCount() const noexcept -> std::size_t {
+    return m_Stages.size();
+  }
+  // Safe to call from any thread. Everything the stage did for the frames
+  // counted in m_Frames happens before the call returns.
+  [[nodiscard]] auto Timing(std::size_t stage) const -> StageTiming {
+    auto const& Current = *m_Stages.at(stage);
+    return {.m_Name = Current.m_Name,
+            .m_Frames =
+                Current.m_Done.load(std::memory_order_acquire) & ~kClosed,
+            .m_Last = std::chrono::nanoseconds{
+                Current.m_LastNs.load(std::memory_order_relaxed)},
+            .m_Average = std::chrono::nanoseconds{
+                Current.m_AverageNs.load(std::memory_order_relaxed)}};
+  }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,160 @@
+#ifndef SHAPE_FRAMESTATS_HPP
+#define SHAPE_FRAMESTATS_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+namespace gl {
+
+// GL work issued during one frame. Binds, program switches and uniform
+// updates count the calls StateCache actually issues, not the elided ones.
+struct FrameCounters {
+  std::uint64_t m_DrawCalls{};
+  std::uint64_t m_Triangles{};
+  std::uint64_t m_VertexArrayBinds{};
+  std::uint64_t m_BufferBinds{};
+  std::uint64_t m_ProgramSwitches{};
+  std::uint64_t m_UniformUpdates{};
+  std::uint64_t m_BufferUploads{};  // BufferData, SubData and Storage calls
+  std::uint64_t m_UploadedBytes{};
+
+  auto operator+=(FrameCounters const& other) noexcept -> FrameCounters& {
+    m_DrawCalls += other.m_DrawCalls;
+    m_Triangles += other.m_Triangles;
+    m_VertexArrayBinds += other.m_VertexArrayBinds;
+    m_BufferBinds += other.m_BufferBinds;
+    m_ProgramSwitches += other.m_ProgramSwitches;
+    m_UniformUpdates += other.m_UniformUpdates;
+    m_BufferUploads += other.m_BufferUploads;
+    m_UploadedBytes += other.m_UploadedBytes;
+    return *this;
+  }
+  auto operator==(FrameCounters const&) const -> bool = default;
+};
+
+// Triangles rasterized by a draw of count vertices or indices.
+constexpr auto TriangleCount(GLenum mode, std::uint64_t count,
+                             std::uint64_t instances = 1) -> std::uint64_t {
+  switch (mode) {
+    case GL_TRIANGLES:
+      return count / 3 * instances;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      return count < 3 ? 0 : (count - 2) * instances;
+    default:
+      return 0;
+  }
+}
+
+// Counts the draws, binds and uploads the shape headers issue, one frame at a
+// time. The wrappers feed Instance() as they issue calls; EndFrame publishes
+// the frame as Last() and, when a log interval is set, logs per-frame
+// averages every interval frames. Raw GL calls are not seen. Only for use on
+// the thread owning the context, like StateCache.
+class FrameStats {
+  FrameCounters m_Current;
+  FrameCounters m_Last;
+  FrameCounters m_Total;
+  FrameCounters m_Interval;
+  std::uint64_t m_IntervalMaxDraws{};
+  std::uint64_t m_Frames{};
+  std::uint64_t m_LogInterval{};
+  spdlog::level::level_enum m_LogLevel{spdlog::level::info};
+
+  FrameStats() = default;
+
+ public:
+  FrameStats(FrameStats const&) = delete;
+  auto operator=(FrameStats const&) -> FrameStats& = delete;
+  FrameStats(FrameStats&&) = delete;
+  auto operator=(FrameStats&&) -> FrameStats& = delete;
+  ~FrameStats() = default;
+
+  static auto Instance() -> FrameStats& {
+    static FrameStats Stats;
+    return Stats;
+  }
+
+  void CountDraw(std::uint64_t triangles) noexcept {
+    ++m_Current.m_DrawCalls;
+    m_Current.m_Triangles += triangles;
+  }
+  void CountVertexArrayBind() noexcept { ++m_Current.m_VertexArrayBinds; }
+  void CountBufferBind() noexcept { ++m_Current.m_BufferBinds; }
+  void CountProgramSwitch() noexcept { ++m_Current.m_ProgramSwitches; }
+  void CountUniformUpdate() noexcept { ++m_Current.m_UniformUpdates; }
+  void CountUpload(std::size_t bytes) noexcept {
+    ++m_Current.m_BufferUploads;
+    m_Current.m_UploadedBytes += bytes;
+  }
+
+  // Logs the averages of the last frames every frames frames; 0 disables it.
+  void SetLogInterval(std::uint64_t frames,
+                      spdlog::level::level_enum level = spdlog::level::info) {
+    m_LogInterval = frames;
+    m_LogLevel = level;
+  }
+  void EndFrame() {
+    m_Last = m_Current;
+    m_Total += m_Current;
+    m_Interval += m_Current;
+    m_IntervalMaxDraws = std::max(m_IntervalMaxDraws, m_Current.m_DrawCalls);
+    m_Current = {};
+    ++m_Frames;
+    if (m_LogInterval != 0 && m_Frames % m_LogInterval == 0) {
+      Log(m_Interval, m_LogInterval);
+      m_Interval = {};
+      m_IntervalMaxDraws = 0;
+    }
+  }
+
+  // Counts of the frame in progress.
+  [[nodiscard]] auto Current() const noexcept -> FrameCounters const& {
+    return m_Current;
+  }
+  // Counts of the last finished frame.
+  [[nodiscard]] auto Last() const noexcept -> FrameCounters const& {
+    return m_Last;
+  }
+  // Sums over every finished frame since the last Reset.
+  [[nodiscard]] auto Total() const noexcept -> FrameCounters const& {
+    return m_Total;
+  }
+  [[nodiscard]] auto Frames() const noexcept -> std::uint64_t {
+    return m_Frames;
+  }
+  void Reset() noexcept {
+    m_Current = {};
+    m_Last = {};
+    m_Total = {};
+    m_Interval = {};
+    m_IntervalMaxDraws = 0;
+    m_Frames = 0;
+  }
+
+ private:
+  void Log(FrameCounters const& sum, std::uint64_t frames) const {
+    if (!spdlog::should_log(m_LogLevel)) {
+      return;
+    }
+    auto const Average = [frames](std::uint64_t value) -> double {
+      return static_cast<double>(value) / static_cast<double>(frames);
+    };
+    spdlog::log(m_LogLevel,
+                "Per frame over {} frames: {:.1f} draws (peak {}), {:.0f} "
+                "triangles, {:.1f} vertex array binds, {:.1f} buffer binds, "
+                "{:.1f} program switches, {:.1f} uniform updates, {:.1f} "
+                "uploads of {:.0f} bytes",
+                frames, Average(sum.m_DrawCalls), m_IntervalMaxDraws,
+                Average(sum.m_Triangles), Average(sum.m_VertexArrayBinds),
+                Average(sum.m_BufferBinds), Average(sum.m_ProgramSwitches),
+                Average(sum.m_UniformUpdates), Average(sum.m_BufferUploads),
+                Average(sum.m_UploadedBytes));
+  }
+};
+
+}  // namespace gl
+#endif
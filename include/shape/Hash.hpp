@@ -0,0 +1,23 @@
+#ifndef SHAPE_HASH_HPP
+#define SHAPE_HASH_HPP
+
+#include <cstdint>
+#include <string_view>
+namespace gl {
+
+// 64-bit FNV-1a. Unlike std::hash it is stable across runs and platforms, so
+// the same value can key on-disk caches too.
+constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+constexpr auto HashBytes(std::string_view bytes,
+                         std::uint64_t seed = kFnvOffsetBasis)
+    -> std::uint64_t {
+  for (auto Byte : bytes) {
+    seed ^= static_cast<std::uint8_t>(Byte);
+    seed *= kFnvPrime;
+  }
+  return seed;
+}
+
+}  // namespace gl
+#endif
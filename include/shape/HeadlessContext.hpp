@@ -0,0 +1,139 @@
+#ifndef SHAPE_HEADLESSCONTEXT_HPP
+#define SHAPE_HEADLESSCONTEXT_HPP
+#include <glad/glad.h>  //
+//
+
+#if __has_include(<EGL/egl.h>) && !defined(SHAPE_NO_HEADLESS_CONTEXT)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define SHAPE_HAS_HEADLESS_CONTEXT 1
+
+#include <array>
+#include <cstdint>
+#include <format>
+#include <shape/Errors.hpp>
+#include <shape/StateCache.hpp>
+#include <utility>
+namespace gl {
+
+// A GL 4.5 core context without any window, created through Mesa's
+// EGL_MESA_platform_surfaceless and rendering into an offscreen RGBA8
+// framebuffer. Loads glad on creation, so everything in shape/ works on
+// build hosts without a display or GPU (llvmpipe).
+class HeadlessContext {
+  EGLDisplay m_Display = EGL_NO_DISPLAY;
+  EGLContext m_Context = EGL_NO_CONTEXT;
+  GLuint m_Framebuffer{};
+  GLuint m_Renderbuffer{};
+  GLsizei m_Width{};
+  GLsizei m_Height{};
+
+  HeadlessContext() = default;
+  void Release() noexcept {
+    if (m_Context != EGL_NO_CONTEXT) {
+      glDeleteFramebuffers(1, &m_Framebuffer);
+      glDeleteRenderbuffers(1, &m_Renderbuffer);
+      eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(m_Display, m_Context);
+      StateCache::Instance().Invalidate();
+    }
+    if (m_Display != EGL_NO_DISPLAY) {
+      eglTerminate(m_Display);
+    }
+    m_Context = EGL_NO_CONTEXT;
+    m_Display = EGL_NO_DISPLAY;
+  }
+  static auto Fail(char const* step) -> gl::errors::State {
+    return {std::format("Headless context: {} failed (EGL error {:#x})", step,
+                        eglGetError()),
+            gl::errors::ErrorLevel::kError};
+  }
+
+ public:
+  static auto Create(GLsizei width = 64, GLsizei height = 64)
+      -> gl::errors::Expected<HeadlessContext> {
+    HeadlessContext Result;
+    Result.m_Width = width;
+    Result.m_Height = height;
+    // NOLINTNEXTLINE
+    auto GetPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (GetPlatformDisplay == nullptr) {
+      return std::unexpected(Fail("eglGetPlatformDisplayEXT lookup"));
+    }
+    Result.m_Display = GetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                          EGL_DEFAULT_DISPLAY, nullptr);
+    EGLint Major = 0;
+    EGLint Minor = 0;
+    if (Result.m_Display == EGL_NO_DISPLAY ||
+        eglInitialize(Result.m_Display, &Major, &Minor) == EGL_FALSE) {
+      return std::unexpected(Fail("eglInitialize"));
+    }
+    eglBindAPI(EGL_OPENGL_API);
+    constexpr auto kAttributes = std::array<EGLint, 7>{
+        EGL_CONTEXT_MAJOR_VERSION,
+        4,
+        EGL_CONTEXT_MINOR_VERSION,
+        5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    Result.m_Context = eglCreateContext(Result.m_Display, EGL_NO_CONFIG_KHR,
+                                        EGL_NO_CONTEXT, kAttributes.data());
+    if (Result.m_Context == EGL_NO_CONTEXT ||
+        eglMakeCurrent(Result.m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       Result.m_Context) == EGL_FALSE) {
+      return std::unexpected(Fail("eglCreateContext"));
+    }
+    // NOLINTNEXTLINE
+    if (gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) ==
+        0) {
+      return std::unexpected(Fail("gladLoadGLLoader"));
+    }
+    StateCache::Instance().Invalidate();
+    glCreateRenderbuffers(1, &Result.m_Renderbuffer);
+    glNamedRenderbufferStorage(Result.m_Renderbuffer, GL_RGBA8, width, height);
+    glCreateFramebuffers(1, &Result.m_Framebuffer);
+    glNamedFramebufferRenderbuffer(Result.m_Framebuffer, GL_COLOR_ATTACHMENT0,
+                                   GL_RENDERBUFFER, Result.m_Renderbuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, Result.m_Framebuffer);
+    glViewport(0, 0, width, height);
+    return Result;
+  }
+  HeadlessContext(HeadlessContext const&) = delete;
+  auto operator=(HeadlessContext const&) -> HeadlessContext& = delete;
+  HeadlessContext(HeadlessContext&& other) noexcept
+      : m_Display(std::exchange(other.m_Display, EGL_NO_DISPLAY)),
+        m_Context(std::exchange(other.m_Context, EGL_NO_CONTEXT)),
+        m_Framebuffer(other.m_Framebuffer),
+        m_Renderbuffer(other.m_Renderbuffer),
+        m_Width(other.m_Width),
+        m_Height(other.m_Height) {}
+  auto operator=(HeadlessContext&& other) noexcept -> HeadlessContext& {
+    if (this != &other) {
+      Release();
+      m_Display = std::exchange(other.m_Display, EGL_NO_DISPLAY);
+      m_Context = std::exchange(other.m_Context, EGL_NO_CONTEXT);
+      m_Framebuffer = other.m_Framebuffer;
+      m_Renderbuffer = other.m_Renderbuffer;
+      m_Width = other.m_Width;
+      m_Height = other.m_Height;
+    }
+    return *this;
+  }
+  ~HeadlessContext() { Release(); }
+
+  [[nodiscard]] auto Width() const noexcept -> GLsizei { return m_Width; }
+  [[nodiscard]] auto Height() const noexcept -> GLsizei { return m_Height; }
+  // RGBA of one pixel of the offscreen framebuffer, origin bottom left.
+  [[nodiscard]] auto ReadPixel(GLint x, GLint y) const
+      -> std::array<std::uint8_t, 4> {
+    std::array<std::uint8_t, 4> Pixel{};
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixel.data());
+    return Pixel;
+  }
+};
+
+}  // namespace gl
+#endif
+#endif
@@ -0,0 +1,217 @@
+#ifndef SHAPE_INSTANCEDMESH_HPP
+#define SHAPE_INSTANCEDMESH_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <shape/Buffer.hpp>
+#include <shape/Color.hpp>
+#include <shape/Errors.hpp>
+#include <shape/FrameStats.hpp>
+#include <shape/QuadBatch.hpp>
+#include <shape/RenderQueue.hpp>
+#include <shape/ShaderCache.hpp>
+#include <shape/StateCache.hpp>
+#include <shape/Vector.hpp>
+#include <shape/VertexArray.hpp>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+namespace gl {
+
+constexpr auto kInstancedVertexShader =
+    R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec4 aOffset; // per instance
+layout (location = 3) in vec2 aScale;  // per instance
+layout (location = 4) in vec4 aColor;  // per instance
+
+out vec4 ourColor;
+
+void main()
+{
+    gl_Position = vec4(aPos.xy * aScale, aPos.z, 1.0) + aOffset;
+    ourColor = aColor;
+}
+)";
+
+// Per-instance attributes, streamed with a divisor of one.
+struct InstanceData {
+  gl::Vector4<float> m_Offset{};
+  gl::Vector2<float> m_Scale{{1.0F, 1.0F}};
+  gl::ColorFloat m_Color{};
+};
+
+// One mesh drawn N times with glDrawElementsInstanced. The mesh is uploaded
+// once; instance data lives in its own buffer and only the range of
+// instances changed since the last Draw is re-uploaded.
+class InstancedMesh {
+  static constexpr auto kInitialCapacity = 64UZ;
+  static constexpr GLuint kPositionLocation = 0;
+  static constexpr GLuint kOffsetLocation = 2;
+  static constexpr GLuint kScaleLocation = 3;
+  static constexpr GLuint kColorLocation = 4;
+  static constexpr GLuint kMeshBinding = 0;
+  static constexpr GLuint kInstanceBinding = 1;
+
+  gl::ProgramHandle m_Program;
+  gl::VertexArray m_VertexArray;
+  gl::Buffer<BufferType::kArray> m_Mesh;
+  gl::Buffer<BufferType::kElementArray> m_Indices;
+  gl::Buffer<BufferType::kArray> m_InstanceBuffer;
+  GLsizei m_IndexCount{};
+  std::size_t m_Capacity{};
+  std::vector<InstanceData> m_Instances;
+  std::size_t m_DirtyBegin{std::numeric_limits<std::size_t>::max()};
+  std::size_t m_DirtyEnd{};
+
+  void MarkDirty(std::size_t first, std::size_t last) {
+    m_DirtyBegin = std::min(m_DirtyBegin, first);
+    m_DirtyEnd = std::max(m_DirtyEnd, last);
+  }
+  void Upload() {
+    if (m_Instances.size() > m_Capacity) {
+      m_Capacity = std::max(m_Capacity, kInitialCapacity);
+      while (m_Capacity < m_Instances.size()) {
+        m_Capacity *= 2;
+      }
+      m_InstanceBuffer.Allocate(m_Capacity * sizeof(InstanceData),
+                                Usage::kDynamicDraw);
+      m_DirtyBegin = 0;
+      m_DirtyEnd = m_Instances.size();
+    }
+    m_DirtyEnd = std::min(m_DirtyEnd, m_Instances.size());
+    if (m_DirtyBegin < m_DirtyEnd) {
+      m_InstanceBuffer.SubData(
+          m_DirtyBegin, std::span<InstanceData const>(m_Instances)
+                            .subspan(m_DirtyBegin, m_DirtyEnd - m_DirtyBegin));
+    }
+    m_DirtyBegin = std::numeric_limits<std::size_t>::max();
+    m_DirtyEnd = 0;
+  }
+
+ public:
+  InstancedMesh(std::span<gl::Vector3<float> const> vertices,
+                std::span<GLuint const> indices,
+                std::string_view vertexShader = kInstancedVertexShader,
+                // NOLINTNEXTLINE
+                std::string_view fragmentShader = kDefaultFragmentShader)
+      : m_IndexCount(static_cast<GLsizei>(indices.size())) {
+    auto Result = ShaderCache::Instance().Get(vertexShader, fragmentShader);
+    if (!Result) {
+      Result.error().Handle();
+    } else {
+      m_Program = *std::move(Result);
+    }
+    m_Mesh.Data(vertices, Usage::kStaticDraw);
+    m_Indices.Data(indices, Usage::kStaticDraw);
+    m_VertexArray.VertexBuffer(kMeshBinding, m_Mesh.Get(), 0,
+                               sizeof(gl::Vector3<float>));
+    m_VertexArray.VertexBuffer(kInstanceBinding, m_InstanceBuffer.Get(), 0,
+                               sizeof(InstanceData));
+    m_VertexArray.BindingDivisor(kInstanceBinding, 1);
+    m_VertexArray.ElementBuffer(m_Indices.Get());
+    m_VertexArray.Attrib({.m_Location = kPositionLocation, .m_Components = 3},
+                         kMeshBinding);
+    m_VertexArray.Attrib(
+        {.m_Location = kOffsetLocation,
+         .m_Components = 4,
+         .m_RelativeOffset = offsetof(InstanceData, m_Offset)},
+        kInstanceBinding);
+    m_VertexArray.Attrib(
+        {.m_Location = kScaleLocation,
+         .m_Components = 2,
+         .m_RelativeOffset = offsetof(InstanceData, m_Scale)},
+        kInstanceBinding);
+    m_VertexArray.Attrib(
+        {.m_Location = kColorLocation,
+         .m_Components = 4,
+         .m_RelativeOffset = offsetof(InstanceData, m_Color)},
+        kInstanceBinding);
+  }
+  // Unit quad spanning [0, 1] x [0, 1], scaled and offset per instance.
+  static auto UnitQuad() -> InstancedMesh {
+    constexpr auto kVertices = std::array{gl::Vector3<float>{{0.0F, 0.0F, 0.0F}},
+                                          gl::Vector3<float>{{1.0F, 0.0F, 0.0F}},
+                                          gl::Vector3<float>{{1.0F, 1.0F, 0.0F}},
+                                          gl::Vector3<float>{{0.0F, 1.0F, 0.0F}}};
+    constexpr auto kIndices = std::array<GLuint, 6>{0U, 1U, 2U, 0U, 2U, 3U};
+    return InstancedMesh{kVertices, kIndices};
+  }
+  InstancedMesh(InstancedMesh const&) = delete;
+  auto operator=(InstancedMesh const&) -> InstancedMesh& = delete;
+  InstancedMesh(InstancedMesh&& other) noexcept
+      : m_Program(std::move(other.m_Program)),
+        m_VertexArray(std::move(other.m_VertexArray)),
+        m_Mesh(std::move(other.m_Mesh)),
+        m_Indices(std::move(other.m_Indices)),
+        m_InstanceBuffer(std::move(other.m_InstanceBuffer)),
+        m_IndexCount(other.m_IndexCount),
+        m_Capacity(std::exchange(other.m_Capacity, 0)),
+        m_Instances(std::move(other.m_Instances)),
+        m_DirtyBegin(other.m_DirtyBegin),
+        m_DirtyEnd(other.m_DirtyEnd) {}
+  auto operator=(InstancedMesh&&) -> InstancedMesh& = delete;
+  ~InstancedMesh() = default;
+
+  auto Add(InstanceData const& instance) -> std::size_t {
+    m_Instances.push_back(instance);
+    MarkDirty(m_Instances.size() - 1, m_Instances.size());
+    return m_Instances.size() - 1;
+  }
+  void Set(std::size_t index, InstanceData const& instance) {
+    m_Instances.at(index) = instance;
+    MarkDirty(index, index + 1);
+  }
+  [[nodiscard]] auto Get(std::size_t index) const -> InstanceData const& {
+    return m_Instances.at(index);
+  }
+  void Clear() noexcept { m_Instances.clear(); }
+  [[nodiscard]] auto Size() const noexcept -> std::size_t {
+    return m_Instances.size();
+  }
+  [[nodiscard]] auto GetProgram() const noexcept -> gl::ProgramHandle const& {
+    return m_Program;
+  }
+
+  void Enqueue(RenderQueue& queue, std::uint8_t layer = 0,
+               bool translucent = false, float depth = 0.0F) {
+    if (m_Instances.empty() || !m_Program) {
+      return;
+    }
+    Upload();
+    auto const Program = m_Program->Get();
+    auto const VertexArray = m_VertexArray.Get().value_or(0);
+    queue.Submit(DrawCommand{
+        .m_Key = translucent
+                     ? sort_key::Translucent(layer, Program, VertexArray, depth)
+                     : sort_key::Opaque(layer, Program, VertexArray, depth),
+        .m_Program = Program,
+        .m_VertexArray = VertexArray,
+        .m_Count = m_IndexCount,
+        .m_Instances = static_cast<GLsizei>(m_Instances.size())});
+  }
+
+  void Draw() {
+    if (m_Instances.empty() || !m_Program) {
+      return;
+    }
+    Upload();
+    StateCache::Instance().UseProgram(m_Program->Get());
+    (void)m_VertexArray.Bind();
+    FrameStats::Instance().CountDraw(
+        TriangleCount(GL_TRIANGLES, static_cast<std::uint64_t>(m_IndexCount),
+                      m_Instances.size()));
+    glDrawElementsInstanced(GL_TRIANGLES, m_IndexCount, GL_UNSIGNED_INT,
+                            nullptr, static_cast<GLsizei>(m_Instances.size()));
+  }
+};
+
+}  // namespace gl
+#endif
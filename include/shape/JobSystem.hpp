@@ -0,0 +1,273 @@
+#ifndef SHAPE_JOBSYSTEM_HPP
+#define SHAPE_JOBSYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace gl {
+
+class JobCounter;
+using Job = std::move_only_function<void()>;
+
+namespace jobs {
+struct Task {
+  Job m_Job;
+  JobCounter* m_Counter{};
+};
+}  // namespace jobs
+
+// Counts the unfinished jobs submitted with it. Jobs submitted to run after a
+// counter are held back until it drops to zero. A counter must outlive its
+// jobs, and must not get new jobs while others wait to run after it.
+class JobCounter {
+  friend class JobSystem;
+
+  mutable std::mutex m_Mutex;
+  std::uint32_t m_Pending{};
+  std::vector<jobs::Task> m_Continuations;
+
+  void Add() {
+    std::scoped_lock const Lock{m_Mutex};
+    ++m_Pending;
+  }
+  // Returns the continuations that became runnable.
+  auto Finish() -> std::vector<jobs::Task> {
+    std::scoped_lock const Lock{m_Mutex};
+    if (--m_Pending != 0) {
+      return {};
+    }
+    return std::exchange(m_Continuations, {});
+  }
+  // Returns the task back when the counter is already done.
+  auto Defer(jobs::Task task) -> std::optional<jobs::Task> {
+    std::scoped_lock const Lock{m_Mutex};
+    if (m_Pending == 0) {
+      return task;
+    }
+    m_Continuations.push_back(std::move(task));
+    return std::nullopt;
+  }
+
+ public:
+  JobCounter() = default;
+  JobCounter(JobCounter const&) = delete;
+  auto operator=(JobCounter const&) -> JobCounter& = delete;
+  JobCounter(JobCounter&&) = delete;
+  auto operator=(JobCounter&&) -> JobCounter& = delete;
+  ~JobCounter() = default;
+
+  // Locks, so a counter seen done may be destroyed right away.
+  [[nodiscard]] auto IsDone() const -> bool {
+    std::scoped_lock const Lock{m_Mutex};
+    return m_Pending == 0;
+  }
+};
+
+// Work-stealing thread pool for per-frame CPU work. Every worker owns a deque:
+// it pushes and pops its own jobs at the back, idle workers steal from the
+// front of the others. Threads outside the pool share one extra deque, and
+// Wait lets them run jobs until a counter is done, so the thread owning the
+// GL context helps instead of blocking. Jobs must not throw and must not issue
+// GL calls.
+class JobSystem {
+  struct alignas(64) Queue {
+    std::mutex m_Mutex;
+    std::deque<jobs::Task> m_Tasks;
+  };
+  // The deque the current thread pushes to, per system.
+  struct Owner {
+    JobSystem const* m_System{};
+    std::size_t m_Queue{};
+  };
+  static auto CurrentOwner() -> Owner& {
+    thread_local Owner Current;
+    return Current;
+  }
+
+  // [0] is shared by outside threads, [1 + n] belongs to worker n
+  std::vector<std::unique_ptr<Queue>> m_Queues;
+  std::vector<std::thread> m_Workers;
+  std::atomic<std::size_t> m_Queued{0};
+  std::atomic<bool> m_Stopping{false};
+  std::mutex m_SleepMutex;
+  std::condition_variable m_Wake;
+
+  [[nodiscard]] auto OwnQueue() const -> std::size_t {
+    auto const& Current = CurrentOwner();
+    return Current.m_System == this ? Current.m_Queue : 0;
+  }
+  void Push(jobs::Task task) {
+    {
+      auto& Target = *m_Queues[OwnQueue()];
+      std::scoped_lock const Lock{Target.m_Mutex};
+      Target.m_Tasks.push_back(std::move(task));
+    }
+    m_Queued.fetch_add(1, std::memory_order_release);
+    // pairs with the predicate check in WorkerLoop, so no wakeup is lost
+    { std::scoped_lock const Lock{m_SleepMutex}; }
+    m_Wake.notify_one();
+  }
+  // Newest job of the own deque, else the oldest one of another.
+  auto Pop(std::size_t own) -> std::optional<jobs::Task> {
+    if (m_Queued.load(std::memory_order_acquire) == 0) {
+      return std::nullopt;
+    }
+    auto Take = [this](Queue& queue, bool newest) -> std::optional<jobs::Task> {
+      std::scoped_lock const Lock{queue.m_Mutex};
+      if (queue.m_Tasks.empty()) {
+        return std::nullopt;
+      }
+      auto& Slot = newest ? queue.m_Tasks.back() : queue.m_Tasks.front();
+      auto Task = std::move(Slot);
+      if (newest) {
+        queue.m_Tasks.pop_back();
+      } else {
+        queue.m_Tasks.pop_front();
+      }
+      m_Queued.fetch_sub(1, std::memory_order_relaxed);
+      return Task;
+    };
+    if (auto Task = Take(*m_Queues[own], true)) {
+      return Task;
+    }
+    for (auto It = 1UZ; It < m_Queues.size(); ++It) {
+      if (auto Task = Take(*m_Queues[(own + It) % m_Queues.size()], false)) {
+        return Task;
+      }
+    }
+    return std::nullopt;
+  }
+  void Run(jobs::Task& task) {
+    task.m_Job();
+    if (task.m_Counter != nullptr) {
+      for (auto& Ready : task.m_Counter->Finish()) {
+        Push(std::move(Ready));
+      }
+    }
+  }
+  void WorkerLoop(std::size_t queue) {
+    CurrentOwner() = {.m_System = this, .m_Queue = queue};
+    while (true) {
+      if (auto Task = Pop(queue)) {
+        Run(*Task);
+        continue;
+      }
+      std::unique_lock Lock{m_SleepMutex};
+      m_Wake.wait(Lock, [this] {
+        return m_Queued.load(std::memory_order_acquire) != 0 ||
+               m_Stopping.load(std::memory_order_relaxed);
+      });
+      if (m_Stopping.load(std::memory_order_relaxed) &&
+          m_Queued.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+    }
+  }
+
+ public:
+  // One worker per hardware thread besides the calling one by default.
+  explicit JobSystem(std::size_t workers = DefaultWorkers()) {
+    m_Queues.reserve(workers + 1);
+    for (auto It = 0UZ; It <= workers; ++It) {
+      m_Queues.push_back(std::make_unique<Queue>());
+    }
+    m_Workers.reserve(workers);
+    for (auto It = 1UZ; It <= workers; ++It) {
+      m_Workers.emplace_back([this, It] { WorkerLoop(It); });
+    }
+  }
+  JobSystem(JobSystem const&) = delete;
+  auto operator=(JobSystem const&) -> JobSystem& = delete;
+  JobSystem(JobSystem&&) = delete;
+  auto operator=(JobSystem&&) -> JobSystem& = delete;
+  // Runs every queued job, then joins the workers.
+  ~JobSystem() {
+    {
+      std::scoped_lock const Lock{m_SleepMutex};
+      m_Stopping.store(true, std::memory_order_relaxed);
+    }
+    m_Wake.notify_all();
+    for (auto& Worker : m_Workers) {
+      Worker.join();
+    }
+  }
+
+  static auto DefaultWorkers() -> std::size_t {
+    auto const Threads = std::thread::hardware_concurrency();
+    return Threads > 1 ? Threads - 1 : 1;
+  }
+  [[nodiscard]] auto WorkerCount() const noexcept -> std::size_t {
+    return m_Workers.size();
+  }
+
+  // Queues job; counter, if given, counts it until it has run. With after,
+  // the job is held back until that counter is done.
+  void Submit(Job job, JobCounter* counter = nullptr,
+              JobCounter* after = nullptr) {
+    if (counter != nullptr) {
+      counter->Add();
+    }
+    jobs::Task Task{.m_Job = std::move(job), .m_Counter = counter};
+    if (after != nullptr) {
+      auto Runnable = after->Defer(std::move(Task));
+      if (!Runnable) {
+        return;
+      }
+      Task = *std::move(Runnable);
+    }
+    Push(std::move(Task));
+  }
+  // Runs queued jobs on the calling thread until counter is done.
+  void Wait(JobCounter const& counter) {
+    auto const Own = OwnQueue();
+    while (!counter.IsDone()) {
+      if (auto Task = Pop(Own)) {
+        Run(*Task);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+  // Calls body(first, last) on disjoint subranges covering [begin, end) and
+  // returns once all ran. Ranges hold grain indices, the last one fewer; with
+  // grain 0 there are about four per thread.
+  template <typename Body>
+    requires std::invocable<Body&, std::size_t, std::size_t>
+  void ParallelFor(std::size_t begin, std::size_t end, Body&& body,
+                   std::size_t grain = 0) {
+    if (begin >= end) {
+      return;
+    }
+    auto const Count = end - begin;
+    if (grain == 0) {
+      grain = std::max(1UZ, Count / ((m_Workers.size() + 1) * 4));
+    }
+    if (grain >= Count) {
+      body(begin, end);
+      return;
+    }
+    JobCounter Done;
+    for (auto First = begin + grain; First < end; First += grain) {
+      Submit([&body, First, Last = std::min(end, First + grain)] {
+               body(First, Last);
+             },
+             &Done);
+    }
+    body(begin, begin + grain);
+    Wait(Done);
+  }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,340 @@
+#ifndef SHAPE_MATRIX_HPP
+#define SHAPE_MATRIX_HPP
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shape/Simd.hpp>
+#include <shape/Vector.hpp>
+#include <span>
+#include <stdexcept>
+namespace gl {
+
+// Column-major like GLSL, so a Matrix<float, 4, 4> can be handed to
+// glUniformMatrix4fv without transposing. Columns are stored back to back.
+template <typename T, std::size_t Rows, std::size_t Columns>
+struct Matrix {
+  std::array<gl::Vector<T, Rows>, Columns> m_Columns;
+
+  constexpr auto At(std::size_t row, std::size_t column) -> T& {
+    return m_Columns[column].m_Values[row];
+  }
+  [[nodiscard]] constexpr auto At(std::size_t row, std::size_t column) const
+      -> T const& {
+    return m_Columns[column].m_Values[row];
+  }
+  [[nodiscard]] auto Data() const noexcept -> T const* {
+    return m_Columns[0].m_Values.data();
+  }
+};
+template <typename T>
+using Mat3 = Matrix<T, 3, 3>;
+template <typename T>
+using Mat4 = Matrix<T, 4, 4>;
+static_assert(sizeof(Mat4<float>) == 16 * sizeof(float));
+
+template <typename T, std::size_t Dimension>
+constexpr auto Identity() -> Matrix<T, Dimension, Dimension> {
+  Matrix<T, Dimension, Dimension> Result{};
+  for (auto It = 0UZ; It < Dimension; ++It) {
+    Result.At(It, It) = T{1};
+  }
+  return Result;
+}
+template <typename T, std::size_t Rows, std::size_t Columns>
+constexpr auto Transpose(Matrix<T, Rows, Columns> const& value)
+    -> Matrix<T, Columns, Rows> {
+  Matrix<T, Columns, Rows> Result;
+  for (auto Row = 0UZ; Row < Rows; ++Row) {
+    for (auto Column = 0UZ; Column < Columns; ++Column) {
+      Result.At(Column, Row) = value.At(Row, Column);
+    }
+  }
+  return Result;
+}
+
+template <typename T, std::size_t Rows, std::size_t Inner, std::size_t Columns>
+constexpr auto operator*(Matrix<T, Rows, Inner> const& lhs,
+                         Matrix<T, Inner, Columns> const& rhs)
+    -> Matrix<T, Rows, Columns> {
+#ifdef SHAPE_SIMD
+  if constexpr (std::same_as<T, float> && Rows == 4 && Inner == 4) {
+    if !consteval {
+      // every result column is a combination of lhs columns
+      simd::Float4 Lhs[4];  // NOLINT
+      for (auto It = 0UZ; It < 4; ++It) {
+        Lhs[It] = simd::Load(lhs.m_Columns[It].m_Values.data());
+      }
+      Matrix<T, Rows, Columns> Result;
+      for (auto Column = 0UZ; Column < Columns; ++Column) {
+        auto const& [X, Y, Z, W] = rhs.m_Columns[Column].m_Values;
+        auto Sum = simd::Mul(Lhs[0], simd::Splat(X));
+        Sum = simd::MulAdd(Lhs[1], simd::Splat(Y), Sum);
+        Sum = simd::MulAdd(Lhs[2], simd::Splat(Z), Sum);
+        Sum = simd::MulAdd(Lhs[3], simd::Splat(W), Sum);
+        simd::Store(Result.m_Columns[Column].m_Values.data(), Sum);
+      }
+      return Result;
+    }
+  }
+#endif
+  Matrix<T, Rows, Columns> Result{};
+  for (auto Column = 0UZ; Column < Columns; ++Column) {
+    for (auto It = 0UZ; It < Inner; ++It) {
+      for (auto Row = 0UZ; Row < Rows; ++Row) {
+        Result.At(Row, Column) += lhs.At(Row, It) * rhs.At(It, Column);
+      }
+    }
+  }
+  return Result;
+}
+template <typename T, std::size_t Rows, std::size_t Columns>
+constexpr auto operator*(Matrix<T, Rows, Columns> const& lhs,
+                         gl::Vector<T, Columns> const& rhs)
+    -> gl::Vector<T, Rows> {
+  Matrix<T, Columns, 1> Column{{rhs}};
+  return (lhs * Column).m_Columns[0];
+}
+
+// Only valid for matrices whose bottom row is (0, 0, 0, 1), which lets every
+// column skip one of the four multiply-adds.
+inline auto MultiplyAffine(Mat4<float> const& lhs, Mat4<float> const& rhs)
+    -> Mat4<float> {
+#ifdef SHAPE_SIMD
+  simd::Float4 Lhs[4];  // NOLINT
+  for (auto It = 0UZ; It < 4; ++It) {
+    Lhs[It] = simd::Load(lhs.m_Columns[It].m_Values.data());
+  }
+  Mat4<float> Result;
+  for (auto Column = 0UZ; Column < 4; ++Column) {
+    auto const& [X, Y, Z, W] = rhs.m_Columns[Column].m_Values;
+    // w is 0 for the linear columns and 1 for the translation
+    auto Sum = Column == 3 ? Lhs[3] : simd::Splat(0.0F);
+    Sum = simd::MulAdd(Lhs[0], simd::Splat(X), Sum);
+    Sum = simd::MulAdd(Lhs[1], simd::Splat(Y), Sum);
+    Sum = simd::MulAdd(Lhs[2], simd::Splat(Z), Sum);
+    simd::Store(Result.m_Columns[Column].m_Values.data(), Sum);
+  }
+  return Result;
+#else
+  return lhs * rhs;
+#endif
+}
+
+template <std::floating_point T>
+constexpr auto Determinant(Mat3<T> const& value) -> T {
+  auto const& [A, B, C] = value.m_Columns;
+  return Dot(A, Cross(B, C));
+}
+template <std::floating_point T>
+constexpr auto Inverse(Mat3<T> const& value) -> std::optional<Mat3<T>> {
+  auto const& [A, B, C] = value.m_Columns;
+  auto const Volume = Dot(A, Cross(B, C));
+  if (Volume == T{}) {
+    return std::nullopt;
+  }
+  // the rows of the inverse are the cross products of the columns
+  auto const Scale = T{1} / Volume;
+  return Transpose(
+      Mat3<T>{{Cross(B, C) * Scale, Cross(C, A) * Scale, Cross(A, B) * Scale}});
+}
+// General inverse by cofactor expansion; std::nullopt when singular.
+template <std::floating_point T>
+constexpr auto Inverse(Mat4<T> const& value) -> std::optional<Mat4<T>> {
+  auto const M = [&value](std::size_t row, std::size_t column) -> T {
+    return value.At(row, column);
+  };
+  // 2x2 minors of the top two and bottom two rows
+  auto const S0 = (M(0, 0) * M(1, 1)) - (M(1, 0) * M(0, 1));
+  auto const S1 = (M(0, 0) * M(1, 2)) - (M(1, 0) * M(0, 2));
+  auto const S2 = (M(0, 0) * M(1, 3)) - (M(1, 0) * M(0, 3));
+  auto const S3 = (M(0, 1) * M(1, 2)) - (M(1, 1) * M(0, 2));
+  auto const S4 = (M(0, 1) * M(1, 3)) - (M(1, 1) * M(0, 3));
+  auto const S5 = (M(0, 2) * M(1, 3)) - (M(1, 2) * M(0, 3));
+  auto const C5 = (M(2, 2) * M(3, 3)) - (M(3, 2) * M(2, 3));
+  auto const C4 = (M(2, 1) * M(3, 3)) - (M(3, 1) * M(2, 3));
+  auto const C3 = (M(2, 1) * M(3, 2)) - (M(3, 1) * M(2, 2));
+  auto const C2 = (M(2, 0) * M(3, 3)) - (M(3, 0) * M(2, 3));
+  auto const C1 = (M(2, 0) * M(3, 2)) - (M(3, 0) * M(2, 2));
+  auto const C0 = (M(2, 0) * M(3, 1)) - (M(3, 0) * M(2, 1));
+  auto const Denominator = (S0 * C5) - (S1 * C4) + (S2 * C3) + (S3 * C2) -
+                           (S4 * C1) + (S5 * C0);
+  if (Denominator == T{}) {
+    return std::nullopt;
+  }
+  auto const Scale = T{1} / Denominator;
+  Mat4<T> Result;
+  Result.At(0, 0) = ((M(1, 1) * C5) - (M(1, 2) * C4) + (M(1, 3) * C3)) * Scale;
+  Result.At(0, 1) = ((-M(0, 1) * C5) + (M(0, 2) * C4) - (M(0, 3) * C3)) * Scale;
+  Result.At(0, 2) = ((M(3, 1) * S5) - (M(3, 2) * S4) + (M(3, 3) * S3)) * Scale;
+  Result.At(0, 3) = ((-M(2, 1) * S5) + (M(2, 2) * S4) - (M(2, 3) * S3)) * Scale;
+  Result.At(1, 0) = ((-M(1, 0) * C5) + (M(1, 2) * C2) - (M(1, 3) * C1)) * Scale;
+  Result.At(1, 1) = ((M(0, 0) * C5) - (M(0, 2) * C2) + (M(0, 3) * C1)) * Scale;
+  Result.At(1, 2) = ((-M(3, 0) * S5) + (M(3, 2) * S2) - (M(3, 3) * S1)) * Scale;
+  Result.At(1, 3) = ((M(2, 0) * S5) - (M(2, 2) * S2) + (M(2, 3) * S1)) * Scale;
+  Result.At(2, 0) = ((M(1, 0) * C4) - (M(1, 1) * C2) + (M(1, 3) * C0)) * Scale;
+  Result.At(2, 1) = ((-M(0, 0) * C4) + (M(0, 1) * C2) - (M(0, 3) * C0)) * Scale;
+  Result.At(2, 2) = ((M(3, 0) * S4) - (M(3, 1) * S2) + (M(3, 3) * S0)) * Scale;
+  Result.At(2, 3) = ((-M(2, 0) * S4) + (M(2, 1) * S2) - (M(2, 3) * S0)) * Scale;
+  Result.At(3, 0) = ((-M(1, 0) * C3) + (M(1, 1) * C1) - (M(1, 2) * C0)) * Scale;
+  Result.At(3, 1) = ((M(0, 0) * C3) - (M(0, 1) * C1) + (M(0, 2) * C0)) * Scale;
+  Result.At(3, 2) = ((-M(3, 0) * S3) + (M(3, 1) * S1) - (M(3, 2) * S0)) * Scale;
+  Result.At(3, 3) = ((M(2, 0) * S3) - (M(2, 1) * S1) + (M(2, 2) * S0)) * Scale;
+  return Result;
+}
+// Inverse of [A t; 0 1] as [A^-1, -A^-1 t; 0 1]: one 3x3 inverse instead of
+// the full cofactor expansion.
+template <std::floating_point T>
+constexpr auto AffineInverse(Mat4<T> const& value) -> std::optional<Mat4<T>> {
+  Mat3<T> Linear;
+  for (auto Column = 0UZ; Column < 3; ++Column) {
+    for (auto Row = 0UZ; Row < 3; ++Row) {
+      Linear.At(Row, Column) = value.At(Row, Column);
+    }
+  }
+  auto const LinearInverse = Inverse(Linear);
+  if (!LinearInverse) {
+    return std::nullopt;
+  }
+  auto const& [X, Y, Z, W] = value.m_Columns[3].m_Values;
+  auto const Translation = *LinearInverse * gl::Vector<T, 3>{{X, Y, Z}};
+  auto Result = Identity<T, 4>();
+  for (auto Column = 0UZ; Column < 3; ++Column) {
+    for (auto Row = 0UZ; Row < 3; ++Row) {
+      Result.At(Row, Column) = LinearInverse->At(Row, Column);
+    }
+  }
+  for (auto Row = 0UZ; Row < 3; ++Row) {
+    Result.At(Row, 3) = -Translation.m_Values[Row];
+  }
+  return Result;
+}
+// Rotation plus translation only: the rotation's inverse is its transpose.
+template <std::floating_point T>
+constexpr auto RigidInverse(Mat4<T> const& value) -> Mat4<T> {
+  auto Result = Identity<T, 4>();
+  for (auto Column = 0UZ; Column < 3; ++Column) {
+    for (auto Row = 0UZ; Row < 3; ++Row) {
+      Result.At(Row, Column) = value.At(Column, Row);
+    }
+  }
+  for (auto Row = 0UZ; Row < 3; ++Row) {
+    T Sum{};
+    for (auto It = 0UZ; It < 3; ++It) {
+      Sum += value.At(It, Row) * value.At(It, 3);
+    }
+    Result.At(Row, 3) = -Sum;
+  }
+  return Result;
+}
+
+// Transform builders, all right-handed with clip z in [-1, 1] like OpenGL.
+template <std::floating_point T>
+constexpr auto Translation(gl::Vector<T, 3> const& offset) -> Mat4<T> {
+  auto Result = Identity<T, 4>();
+  auto const& [X, Y, Z] = offset.m_Values;
+  Result.m_Columns[3] = gl::Vector<T, 4>{{X, Y, Z, T{1}}};
+  return Result;
+}
+template <std::floating_point T>
+constexpr auto Scaling(gl::Vector<T, 3> const& factors) -> Mat4<T> {
+  auto Result = Identity<T, 4>();
+  for (auto It = 0UZ; It < 3; ++It) {
+    Result.At(It, It) = factors.m_Values[It];
+  }
+  return Result;
+}
+// Rotation by radians about a unit axis (Rodrigues).
+template <std::floating_point T>
+auto Rotation(gl::Vector<T, 3> const& axis, T radians) -> Mat4<T> {
+  auto const Cos = std::cos(radians);
+  auto const Sin = std::sin(radians);
+  auto const OneMinusCos = T{1} - Cos;
+  auto const& [X, Y, Z] = axis.m_Values;
+  auto Result = Identity<T, 4>();
+  Result.m_Columns[0] =
+      gl::Vector<T, 4>{{Cos + (X * X * OneMinusCos),
+                        (Y * X * OneMinusCos) + (Z * Sin),
+                        (Z * X * OneMinusCos) - (Y * Sin), T{}}};
+  Result.m_Columns[1] =
+      gl::Vector<T, 4>{{(X * Y * OneMinusCos) - (Z * Sin),
+                        Cos + (Y * Y * OneMinusCos),
+                        (Z * Y * OneMinusCos) + (X * Sin), T{}}};
+  Result.m_Columns[2] =
+      gl::Vector<T, 4>{{(X * Z * OneMinusCos) + (Y * Sin),
+                        (Y * Z * OneMinusCos) - (X * Sin),
+                        Cos + (Z * Z * OneMinusCos), T{}}};
+  return Result;
+}
+template <std::floating_point T>
+auto Perspective(T fieldOfViewY, T aspect, T nearPlane,
+                 T farPlane) -> Mat4<T> {
+  auto const Focal = T{1} / std::tan(fieldOfViewY / T{2});
+  Mat4<T> Result{};
+  Result.At(0, 0) = Focal / aspect;
+  Result.At(1, 1) = Focal;
+  Result.At(2, 2) = (farPlane + nearPlane) / (nearPlane - farPlane);
+  Result.At(2, 3) = (T{2} * farPlane * nearPlane) /
+                    (nearPlane - farPlane);
+  Result.At(3, 2) = T{-1};
+  return Result;
+}
+template <std::floating_point T>
+constexpr auto Orthographic(T left, T right, T bottom, T top,
+                            T nearPlane, T farPlane)
+    -> Mat4<T> {
+  auto Result = Identity<T, 4>();
+  Result.At(0, 0) = T{2} / (right - left);
+  Result.At(1, 1) = T{2} / (top - bottom);
+  Result.At(2, 2) = T{-2} / (farPlane - nearPlane);
+  Result.At(0, 3) = -(right + left) / (right - left);
+  Result.At(1, 3) = -(top + bottom) / (top - bottom);
+  Result.At(2, 3) = -(farPlane + nearPlane) / (farPlane - nearPlane);
+  return Result;
+}
+template <std::floating_point T>
+auto LookAt(gl::Vector<T, 3> const& eye, gl::Vector<T, 3> const& target,
+            gl::Vector<T, 3> const& up) -> Mat4<T> {
+  auto const Forward = Normalize(target - eye);
+  auto const Side = Normalize(Cross(Forward, up));
+  auto const Up = Cross(Side, Forward);
+  auto Result = Identity<T, 4>();
+  for (auto Column = 0UZ; Column < 3; ++Column) {
+    Result.At(0, Column) = Side.m_Values[Column];
+    Result.At(1, Column) = Up.m_Values[Column];
+    Result.At(2, Column) = -Forward.m_Values[Column];
+  }
+  Result.At(0, 3) = -Dot(Side, eye);
+  Result.At(1, 3) = -Dot(Up, eye);
+  Result.At(2, 3) = Dot(Forward, eye);
+  return Result;
+}
+
+// world[i] = world[parents[i]] * local[i], or local[i] for roots (parent
+// -1). Nodes must come after their parent, which makes this one linear pass;
+// all locals must be affine.
+inline void ComposeWorldMatrices(std::span<Mat4<float> const> local,
+                                 std::span<std::int32_t const> parents,
+                                 std::span<Mat4<float>> world) {
+  if (local.size() != parents.size() || local.size() != world.size()) {
+    throw std::invalid_argument("Span sizes differ");
+  }
+  for (auto Node = 0UZ; Node < local.size(); ++Node) {
+    auto const Parent = parents[Node];
+    if (Parent < 0) {
+      world[Node] = local[Node];
+      continue;
+    }
+    if (static_cast<std::size_t>(Parent) >= Node) {
+      throw std::invalid_argument("Parent must precede its children");
+    }
+    world[Node] = MultiplyAffine(world[static_cast<std::size_t>(Parent)],
+                                 local[Node]);
+  }
+}
+
+}  // namespace gl
+#endif
@@ -0,0 +1,149 @@
+#ifndef SHAPE_MESHARENA_HPP
+#define SHAPE_MESHARENA_HPP
+#include <glad/glad.h>  //
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <shape/Buffer.hpp>
+#include <shape/Errors.hpp>
+#include <shape/FrameStats.hpp>
+#include <shape/Point.hpp>
+#include <shape/QuadBatch.hpp>
+#include <shape/ShaderCache.hpp>
+#include <shape/StateCache.hpp>
+#include <shape/VertexArray.hpp>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// Layout mandated by glMultiDrawElementsIndirect.
+struct DrawElementsIndirectCommand {
+  GLuint m_Count{};
+  GLuint m_InstanceCount{1};
+  GLuint m_FirstIndex{};
+  GLint m_BaseVertex{};
+  GLuint m_BaseInstance{};
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(GLuint));
+
+// Packs many static meshes into one shared vertex and one shared index
+// buffer and draws all of them with a single glMultiDrawElementsIndirect.
+// Every mesh owns one command; hiding a mesh only zeroes its instance count,
+// so visibility changes re-upload 20 bytes instead of rebuilding the arena.
+class MeshArena {
+ public:
+  using MeshId = std::uint32_t;
+
+ private:
+  gl::ProgramHandle m_Program;
+  GLint m_OffsetLocation{-1};
+  gl::VertexArray m_VertexArray;
+  gl::Buffer<BufferType::kArray> m_Vertices;
+  gl::Buffer<BufferType::kElementArray> m_Indices;
+  gl::Buffer<BufferType::kDrawIndirect> m_Commands;
+  std::vector<gl::Point> m_VertexData;
+  std::vector<GLuint> m_IndexData;
+  std::vector<DrawElementsIndirectCommand> m_CommandData;
+  std::vector<GLuint> m_MeshInstances;  // instance count while visible
+  bool m_GeometryDirty = false;
+  bool m_CommandsDirty = false;
+
+  void Upload() {
+    if (m_GeometryDirty) {
+      // static data: respecify everything instead of tracking ranges
+      m_Vertices.Data(m_VertexData, Usage::kStaticDraw);
+      m_Indices.Data(m_IndexData, Usage::kStaticDraw);
+      m_Commands.Data(m_CommandData, Usage::kDynamicDraw);
+    } else if (m_CommandsDirty) {
+      m_Commands.SubData(0, m_CommandData);
+    }
+    m_GeometryDirty = false;
+    m_CommandsDirty = false;
+  }
+
+ public:
+  explicit MeshArena(std::string_view vertexShader = kDefaultVertexShader,
+                     // NOLINTNEXTLINE
+                     std::string_view fragmentShader = kDefaultFragmentShader) {
+    auto Result = ShaderCache::Instance().Get(vertexShader, fragmentShader);
+    if (!Result) {
+      Result.error().Handle();
+    } else {
+      m_Program = *std::move(Result);
+      m_OffsetLocation = glGetUniformLocation(m_Program->Get(), "offset");
+    }
+    m_VertexArray.VertexBuffer(0, m_Vertices.Get(), 0, sizeof(gl::Point));
+    m_VertexArray.ElementBuffer(m_Indices.Get());
+    m_VertexArray.Attrib({.m_Location = 0, .m_Components = 3}, 0);
+    m_VertexArray.Attrib(
+        {.m_Location = 1,
+         .m_Components = 4,
+         .m_RelativeOffset = offsetof(gl::Point, m_Color)},
+        0);
+  }
+  MeshArena(MeshArena const&) = delete;
+  auto operator=(MeshArena const&) -> MeshArena& = delete;
+  MeshArena(MeshArena&&) = delete;
+  auto operator=(MeshArena&&) -> MeshArena& = delete;
+  ~MeshArena() = default;
+
+  // Indices are relative to the mesh's own vertices.
+  auto Add(std::span<gl::Point const> vertices, std::span<GLuint const> indices,
+           GLuint instances = 1) -> MeshId {
+    m_CommandData.push_back(
+        {.m_Count = static_cast<GLuint>(indices.size()),
+         .m_InstanceCount = instances,
+         .m_FirstIndex = static_cast<GLuint>(m_IndexData.size()),
+         .m_BaseVertex = static_cast<GLint>(m_VertexData.size())});
+    m_MeshInstances.push_back(instances);
+    m_VertexData.insert(m_VertexData.end(), vertices.begin(), vertices.end());
+    m_IndexData.insert(m_IndexData.end(), indices.begin(), indices.end());
+    m_GeometryDirty = true;
+    return static_cast<MeshId>(m_CommandData.size() - 1);
+  }
+  void SetVisible(MeshId mesh, bool visible) {
+    auto& Command = m_CommandData.at(mesh);
+    auto const Instances = visible ? m_MeshInstances[mesh] : 0U;
+    if (Command.m_InstanceCount != Instances) {
+      Command.m_InstanceCount = Instances;
+      m_CommandsDirty = true;
+    }
+  }
+  [[nodiscard]] auto IsVisible(MeshId mesh) const -> bool {
+    return m_CommandData.at(mesh).m_InstanceCount != 0;
+  }
+  [[nodiscard]] auto Size() const noexcept -> std::size_t {
+    return m_CommandData.size();
+  }
+  [[nodiscard]] auto Commands() const noexcept
+      -> std::span<DrawElementsIndirectCommand const> {
+    return m_CommandData;
+  }
+
+  void Draw() {
+    if (m_CommandData.empty() || !m_Program) {
+      return;
+    }
+    Upload();
+    auto& State = StateCache::Instance();
+    State.UseProgram(m_Program->Get());
+    State.Uniform4f(m_OffsetLocation, 0.0F, 0.0F, 0.0F, 0.0F);
+    (void)m_VertexArray.Bind();
+    m_Commands.Bind();
+    auto Triangles = 0ULL;
+    for (auto const& Command : m_CommandData) {
+      Triangles += TriangleCount(GL_TRIANGLES, Command.m_Count,
+                                 Command.m_InstanceCount);
+    }
+    FrameStats::Instance().CountDraw(Triangles);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_CommandData.size()),
+                                0);
+  }
+};
+
+}  // namespace gl
+#endif
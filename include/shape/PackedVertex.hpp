@@ -0,0 +1,250 @@
+#ifndef SHAPE_PACKEDVERTEX_HPP
+#define SHAPE_PACKEDVERTEX_HPP
+#include <glad/glad.h>  //
+//
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <shape/Color.hpp>
+#include <shape/ColorKernels.hpp>
+#include <shape/Point.hpp>
+#include <shape/VectorKernels.hpp>
+#include <shape/VertexStream.hpp>
+#include <span>
+#include <stdexcept>
+namespace gl {
+
+// Opt-in compact vertex formats. A gl::Point takes 28 bytes; a PackedPoint
+// (half-float position, RGBA8 color) takes 12, which is what bandwidth-bound
+// meshes should use. ColorInt is the RGBA8 format: it is uploaded as
+// normalized GL_UNSIGNED_BYTE, see AttribTraits<ColorInt>. Positions are
+// padded to four components so every attribute stays 4 byte aligned.
+
+// xyz as IEEE half floats, the fourth value is padding.
+struct HalfPosition {
+  std::array<std::uint16_t, 4> m_Values;
+};
+// xyz as 16-bit snorm, i.e. [-1, 1] in steps of 1/32767; fourth is padding.
+struct Snorm16Position {
+  std::array<std::int16_t, 4> m_Values;
+};
+struct PackedPoint {
+  HalfPosition m_Position{};
+  ColorInt m_Color{};
+};
+static_assert(sizeof(PackedPoint) == 12);
+
+template <>
+struct AttribTraits<HalfPosition> {
+  static constexpr GLint kComponents = 3;
+  static constexpr GLenum kType = GL_HALF_FLOAT;
+  static constexpr bool kNormalized = false;
+  static constexpr bool kInteger = false;
+};
+template <>
+struct AttribTraits<Snorm16Position> {
+  static constexpr GLint kComponents = 3;
+  static constexpr GLenum kType = GL_SHORT;
+  static constexpr bool kNormalized = true;
+  static constexpr bool kInteger = false;
+};
+
+// Round to nearest even, like F16C; overflow gives infinity.
+constexpr auto ToHalf(float value) -> std::uint16_t {
+  auto const Bits = std::bit_cast<std::uint32_t>(value);
+  auto const Sign = (Bits >> 16U) & 0x8000U;
+  auto const BiasedExponent = (Bits >> 23U) & 0xFFU;
+  auto Mantissa = Bits & 0x7FFFFFU;
+  if (BiasedExponent == 0xFFU) {
+    return static_cast<std::uint16_t>(Sign | 0x7C00U |
+                                      (Mantissa != 0 ? 0x200U : 0U));
+  }
+  auto const Exponent = static_cast<int>(BiasedExponent) - 127 + 15;
+  if (Exponent >= 31) {
+    return static_cast<std::uint16_t>(Sign | 0x7C00U);
+  }
+  auto Round = [](std::uint32_t kept, std::uint32_t rest,
+                  std::uint32_t midpoint) {
+    return (rest > midpoint || (rest == midpoint && (kept & 1U) != 0))
+               ? kept + 1
+               : kept;
+  };
+  if (Exponent <= 0) {
+    // subnormal half, or zero below half of the smallest one
+    if (Exponent < -10) {
+      return static_cast<std::uint16_t>(Sign);
+    }
+    Mantissa |= 0x800000U;
+    auto const Shift = static_cast<std::uint32_t>(14 - Exponent);
+    return static_cast<std::uint16_t>(
+        Sign | Round(Mantissa >> Shift, Mantissa & ((1U << Shift) - 1),
+                     1U << (Shift - 1)));
+  }
+  // a carry out of the mantissa correctly rounds up into the exponent
+  return static_cast<std::uint16_t>(
+      Sign | Round((static_cast<std::uint32_t>(Exponent) << 10U) |
+                       (Mantissa >> 13U),
+                   Mantissa & 0x1FFFU, 0x1000U));
+}
+constexpr auto FromHalf(std::uint16_t half) -> float {
+  auto const Sign = (half & 0x8000U) << 16U;
+  auto const Exponent = (half >> 10U) & 0x1FU;
+  auto const Mantissa = half & 0x3FFU;
+  if (Exponent == 0) {
+    auto const Magnitude = static_cast<float>(Mantissa) / 16777216.0F;
+    return Sign != 0 ? -Magnitude : Magnitude;
+  }
+  auto const Exponent32 =
+      Exponent == 0x1FU ? 0xFFU : static_cast<std::uint32_t>(Exponent) + 112U;
+  return std::bit_cast<float>(Sign | (Exponent32 << 23U) |
+                              (static_cast<std::uint32_t>(Mantissa) << 13U));
+}
+// NaN packs to the low end, like the SSE min/max clamps.
+inline auto ToSnorm16(float value) -> std::int16_t {
+  auto const Clamped = value > -1.0F ? std::min(value, 1.0F) : -1.0F;
+  return static_cast<std::int16_t>(std::nearbyint(Clamped * 32767.0F));
+}
+
+namespace kernels {
+
+inline void PackHalfScalar(std::span<Point const> points,
+                           std::span<HalfPosition> out) {
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    auto const& Position = points[It].m_Position.m_Values;
+    out[It].m_Values = {ToHalf(Position[0]), ToHalf(Position[1]),
+                        ToHalf(Position[2]), 0};
+  }
+}
+inline void PackSnorm16Scalar(std::span<Point const> points,
+                              std::span<Snorm16Position> out, float scale) {
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    auto const& Position = points[It].m_Position.m_Values;
+    out[It].m_Values = {ToSnorm16(Position[0] * scale),
+                        ToSnorm16(Position[1] * scale),
+                        ToSnorm16(Position[2] * scale), 0};
+  }
+}
+inline void PackColorsScalar(std::span<Point const> points,
+                             std::span<ColorInt> out) {
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    out[It] = ToColorInt(points[It].m_Color);
+  }
+}
+
+#ifdef SHAPE_KERNEL_DISPATCH
+SHAPE_TARGET("f16c")
+inline void PackHalfF16c(std::span<Point const> points,
+                         std::span<HalfPosition> out) {
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    auto const& Position = points[It].m_Position.m_Values;
+    auto const Xyz = _mm_setr_ps(Position[0], Position[1], Position[2], 0.0F);
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(out[It].m_Values.data()),  // NOLINT
+        _mm_cvtps_ph(Xyz, _MM_FROUND_TO_NEAREST_INT));
+  }
+}
+SHAPE_TARGET("sse2")
+inline void PackSnorm16Sse2(std::span<Point const> points,
+                            std::span<Snorm16Position> out, float scale) {
+  auto const Scale = _mm_set1_ps(scale);
+  auto const Low = _mm_set1_ps(-1.0F);
+  auto const High = _mm_set1_ps(1.0F);
+  auto const Range = _mm_set1_ps(32767.0F);
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    auto const& Position = points[It].m_Position.m_Values;
+    auto Xyz = _mm_setr_ps(Position[0], Position[1], Position[2], 0.0F);
+    // max first, it returns its second operand for NaN lanes
+    Xyz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(Xyz, Scale), Low), High);
+    auto const Words = _mm_cvtps_epi32(_mm_mul_ps(Xyz, Range));
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(out[It].m_Values.data()),  // NOLINT
+        _mm_packs_epi32(Words, Words));
+  }
+}
+SHAPE_TARGET("sse2")
+inline void PackColorsSse2(std::span<Point const> points,
+                           std::span<ColorInt> out) {
+  auto const Zero = _mm_setzero_ps();
+  auto const One = _mm_set1_ps(1.0F);
+  auto const Range = _mm_set1_ps(255.0F);
+  for (auto It = 0UZ; It < points.size(); ++It) {
+    auto Color = _mm_loadu_ps(&points[It].m_Color.red.val);
+    Color = _mm_min_ps(_mm_max_ps(Color, Zero), One);
+    auto Packed = _mm_cvtps_epi32(_mm_mul_ps(Color, Range));
+    Packed = _mm_packs_epi32(Packed, Packed);
+    Packed = _mm_packus_epi16(Packed, Packed);
+    auto const Bytes = _mm_cvtsi128_si32(Packed);
+    std::memcpy(&out[It], &Bytes, sizeof(ColorInt));
+  }
+}
+#endif
+
+inline void CheckPackSizes(std::size_t points, std::size_t out) {
+  if (points != out) {
+    throw std::invalid_argument("vertex packing: spans differ in length");
+  }
+}
+
+}  // namespace kernels
+
+// Half-float positions; exact for integers up to 2048 and within 2^-11
+// relative error elsewhere.
+inline void PackPositions(std::span<Point const> points,
+                          std::span<HalfPosition> out) {
+  kernels::CheckPackSizes(points.size(), out.size());
+#ifdef SHAPE_KERNEL_DISPATCH
+  if (ActiveIsa() >= Isa::kAvx2) {
+    kernels::PackHalfF16c(points, out);
+    return;
+  }
+#endif
+  kernels::PackHalfScalar(points, out);
+}
+// Snorm positions of position * scale, clamped to [-1, 1]; the vertex shader
+// divides by scale again. The default suits normalized device coordinates.
+inline void PackPositions(std::span<Point const> points,
+                          std::span<Snorm16Position> out, float scale = 1.0F) {
+  kernels::CheckPackSizes(points.size(), out.size());
+#ifdef SHAPE_KERNEL_DISPATCH
+  if (ActiveIsa() >= Isa::kSse2) {
+    kernels::PackSnorm16Sse2(points, out, scale);
+    return;
+  }
+#endif
+  kernels::PackSnorm16Scalar(points, out, scale);
+}
+// Colors clamped to [0, 1] and rounded to the nearest of 256 levels.
+inline void PackColors(std::span<Point const> points, std::span<ColorInt> out) {
+  kernels::CheckPackSizes(points.size(), out.size());
+#ifdef SHAPE_KERNEL_DISPATCH
+  if (ActiveIsa() >= Isa::kSse2) {
+    kernels::PackColorsSse2(points, out);
+    return;
+  }
+#endif
+  kernels::PackColorsScalar(points, out);
+}
+inline void Pack(std::span<Point const> points, std::span<PackedPoint> out) {
+  kernels::CheckPackSizes(points.size(), out.size());
+  constexpr auto kChunk = 256UZ;
+  std::array<HalfPosition, kChunk> Positions{};
+  std::array<ColorInt, kChunk> Colors{};
+  for (auto First = 0UZ; First < points.size(); First += kChunk) {
+    auto const Count = std::min(kChunk, points.size() - First);
+    auto const Chunk = points.subspan(First, Count);
+    PackPositions(Chunk, std::span(Positions).first(Count));
+    PackColors(Chunk, std::span(Colors).first(Count));
+    for (auto It = 0UZ; It < Count; ++It) {
+      out[First + It] = {.m_Position = Positions.at(It),
+                         .m_Color = Colors.at(It)};
+    }
+  }
+}
+
+}  // namespace gl
+#endif
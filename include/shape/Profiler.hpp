@@ -0,0 +1,440 @@
+#ifndef SHAPE_PROFILER_HPP
+#define SHAPE_PROFILER_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace gl {
+
+enum struct SampleKind : std::uint8_t { kCpu, kGpu };
+
+// One timed scope. Names must outlive the profiler, pass string literals.
+struct ProfileSample {
+  char const* m_Name{};
+  std::int64_t m_Begin{};     // steady_clock nanoseconds
+  std::int64_t m_Duration{};  // nanoseconds
+  std::uint32_t m_Thread{};   // ring of the thread, reused after it exits
+  SampleKind m_Kind{SampleKind::kCpu};
+};
+
+// Single producer, single consumer ring: the owning thread pushes finished
+// scopes without locking, the profiler drains them once per frame. A full
+// ring drops new samples instead of blocking the producer.
+class SampleRing {
+ public:
+  static constexpr auto kCapacity = 4096UZ;
+
+ private:
+  static constexpr auto kCacheLine = 64UZ;
+  std::array<ProfileSample, kCapacity> m_Samples{};
+  alignas(kCacheLine) std::atomic<std::uint64_t> m_Written{};
+  alignas(kCacheLine) std::atomic<std::uint64_t> m_Read{};
+  std::atomic<std::uint64_t> m_Dropped{};
+  std::uint32_t m_Thread;
+
+ public:
+  explicit SampleRing(std::uint32_t thread) : m_Thread{thread} {}
+
+  [[nodiscard]] auto Thread() const noexcept -> std::uint32_t {
+    return m_Thread;
+  }
+  auto Push(ProfileSample sample) noexcept -> bool {
+    auto const Written = m_Written.load(std::memory_order_relaxed);
+    if (Written - m_Read.load(std::memory_order_acquire) == kCapacity) {
+      m_Dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    sample.m_Thread = m_Thread;
+    m_Samples[Written % kCapacity] = sample;
+    m_Written.store(Written + 1, std::memory_order_release);
+    return true;
+  }
+  template <typename Consumer>
+  void Drain(Consumer&& consumer) {
+    auto Read = m_Read.load(std::memory_order_relaxed);
+    auto const Written = m_Written.load(std::memory_order_acquire);
+    for (; Read != Written; ++Read) {
+      consumer(m_Samples[Read % kCapacity]);
+    }
+    m_Read.store(Read, std::memory_order_release);
+  }
+  [[nodiscard]] auto Dropped() const noexcept -> std::uint64_t {
+    return m_Dropped.load(std::memory_order_relaxed);
+  }
+};
+
+// Per-scope timings over the last kWindow frames a scope appeared in; a
+// scope entered several times in a frame counts with its summed duration.
+struct ScopeStats {
+  std::string_view m_Name;
+  SampleKind m_Kind{SampleKind::kCpu};
+  std::size_t m_Frames{};
+  double m_MinMs{};
+  double m_AvgMs{};
+  double m_P99Ms{};
+  double m_MaxMs{};
+};
+
+// Frame profiler. CPU scopes may be recorded on any thread; GPU scopes,
+// BeginFrame and EndFrame belong to the thread owning the context. GPU scopes
+// are GL_TIME_ELAPSED queries read back one frame later, and only if the
+// driver has them ready, so profiling never stalls the pipeline. Time-elapsed
+// queries cannot nest: a GPU scope inside another one is ignored.
+class Profiler {
+ public:
+  static constexpr auto kWindow = 240UZ;
+  static constexpr auto kMaxGpuScopes = 64UZ;
+  static constexpr auto kGpuThread = std::numeric_limits<std::uint32_t>::max();
+  static constexpr auto kFrameScope = "Frame";
+
+ private:
+  struct GpuFrame {
+    std::array<GLuint, kMaxGpuScopes> m_Queries{};
+    std::array<char const*, kMaxGpuScopes> m_Names{};
+    std::array<std::int64_t, kMaxGpuScopes> m_Issued{};
+    std::size_t m_Count{};
+  };
+  struct History {
+    std::array<std::int64_t, kWindow> m_Durations{};
+    std::size_t m_Count{};
+    std::size_t m_Next{};
+  };
+  struct Key {
+    std::string_view m_Name;
+    SampleKind m_Kind;
+    auto operator==(Key const&) const -> bool = default;
+  };
+  struct KeyHash {
+    auto operator()(Key const& key) const noexcept -> std::size_t {
+      return std::hash<std::string_view>{}(key.m_Name) ^
+             static_cast<std::size_t>(key.m_Kind);
+    }
+  };
+
+  std::atomic<bool> m_Enabled{true};
+  std::mutex m_RingsMutex;
+  std::vector<std::unique_ptr<SampleRing>> m_Rings;
+  std::vector<SampleRing*> m_FreeRings;
+  std::array<GpuFrame, 2> m_Gpu{};
+  std::size_t m_GpuFrame{};
+  bool m_GpuCreated{false};
+  bool m_GpuOpen{false};
+  std::uint64_t m_GpuDropped{};
+  std::int64_t m_FrameBegin{};
+  std::uint64_t m_Frames{};
+  std::vector<ProfileSample> m_LastFrame;
+  std::unordered_map<Key, std::int64_t, KeyHash> m_FrameTotals;
+  std::unordered_map<Key, History, KeyHash> m_History;
+
+  Profiler() = default;
+
+  // Hands the ring of an exiting thread to the next new thread, so short
+  // lived workers do not pile up rings. Samples left in it are still drained.
+  struct RingLease {
+    SampleRing* m_Ring{};
+    RingLease() = default;
+    RingLease(RingLease const&) = delete;
+    auto operator=(RingLease const&) -> RingLease& = delete;
+    RingLease(RingLease&&) = delete;
+    auto operator=(RingLease&&) -> RingLease& = delete;
+    ~RingLease() {
+      if (m_Ring != nullptr) {
+        auto& Shared = Instance();
+        std::scoped_lock const Lock{Shared.m_RingsMutex};
+        Shared.m_FreeRings.push_back(m_Ring);
+      }
+    }
+  };
+  auto LocalRing() -> SampleRing& {
+    thread_local RingLease Lease;
+    if (Lease.m_Ring == nullptr) {
+      std::scoped_lock const Lock{m_RingsMutex};
+      if (m_FreeRings.empty()) {
+        m_Rings.push_back(std::make_unique<SampleRing>(
+            static_cast<std::uint32_t>(m_Rings.size())));
+        Lease.m_Ring = m_Rings.back().get();
+      } else {
+        Lease.m_Ring = m_FreeRings.back();
+        m_FreeRings.pop_back();
+      }
+    }
+    return *Lease.m_Ring;
+  }
+  void CollectGpu() {
+    if (m_GpuOpen) {
+      glEndQuery(GL_TIME_ELAPSED);
+      m_GpuOpen = false;
+    }
+    m_GpuFrame = (m_GpuFrame + 1) % m_Gpu.size();
+    // the other slot was filled a frame ago and gets reused next
+    auto& Previous = m_Gpu.at(m_GpuFrame);
+    if (Previous.m_Count == 0) {
+      return;
+    }
+    GLint Available = GL_FALSE;
+    glGetQueryObjectiv(Previous.m_Queries.at(Previous.m_Count - 1),
+                       GL_QUERY_RESULT_AVAILABLE, &Available);
+    if (Available == GL_FALSE) {
+      m_GpuDropped += Previous.m_Count;
+    } else {
+      for (auto It = 0UZ; It < Previous.m_Count; ++It) {
+        GLuint64 Elapsed{};
+        glGetQueryObjectui64v(Previous.m_Queries.at(It), GL_QUERY_RESULT,
+                              &Elapsed);
+        // the GPU start is unknown, the CPU time of issue stands in for it
+        m_LastFrame.push_back(
+            {.m_Name = Previous.m_Names.at(It),
+             .m_Begin = Previous.m_Issued.at(It),
+             .m_Duration = static_cast<std::int64_t>(Elapsed),
+             .m_Thread = kGpuThread,
+             .m_Kind = SampleKind::kGpu});
+      }
+    }
+    Previous.m_Count = 0;
+  }
+  void Aggregate() {
+    m_FrameTotals.clear();
+    for (auto const& Sample : m_LastFrame) {
+      m_FrameTotals[{Sample.m_Name, Sample.m_Kind}] += Sample.m_Duration;
+    }
+    for (auto const& [Scope, Total] : m_FrameTotals) {
+      auto& Entry = m_History[Scope];
+      Entry.m_Durations.at(Entry.m_Next) = Total;
+      Entry.m_Next = (Entry.m_Next + 1) % kWindow;
+      Entry.m_Count = std::min(Entry.m_Count + 1, kWindow);
+    }
+  }
+
+ public:
+  Profiler(Profiler const&) = delete;
+  auto operator=(Profiler const&) -> Profiler& = delete;
+  Profiler(Profiler&&) = delete;
+  auto operator=(Profiler&&) -> Profiler& = delete;
+  // Query objects are left to the context, see ReleaseGpu.
+  ~Profiler() = default;
+
+  static auto Instance() -> Profiler& {
+    static Profiler Shared;
+    return Shared;
+  }
+  static auto Now() noexcept -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void SetEnabled(bool enabled) noexcept {
+    m_Enabled.store(enabled, std::memory_order_relaxed);
+  }
+  [[nodiscard]] auto IsEnabled() const noexcept -> bool {
+    return m_Enabled.load(std::memory_order_relaxed);
+  }
+
+  void RecordCpu(char const* name, std::int64_t begin, std::int64_t end) {
+    LocalRing().Push(
+        {.m_Name = name, .m_Begin = begin, .m_Duration = end - begin});
+  }
+  auto BeginGpu(char const* name) -> bool {
+    if (!IsEnabled() || m_GpuOpen) {
+      return false;
+    }
+    if (!m_GpuCreated) {
+      for (auto& Frame : m_Gpu) {
+        glGenQueries(static_cast<GLsizei>(kMaxGpuScopes),
+                     Frame.m_Queries.data());
+      }
+      m_GpuCreated = true;
+    }
+    auto& Frame = m_Gpu.at(m_GpuFrame);
+    if (Frame.m_Count == kMaxGpuScopes) {
+      ++m_GpuDropped;
+      return false;
+    }
+    Frame.m_Names.at(Frame.m_Count) = name;
+    Frame.m_Issued.at(Frame.m_Count) = Now();
+    glBeginQuery(GL_TIME_ELAPSED, Frame.m_Queries.at(Frame.m_Count));
+    ++Frame.m_Count;
+    m_GpuOpen = true;
+    return true;
+  }
+  void EndGpu() {
+    if (m_GpuOpen) {
+      glEndQuery(GL_TIME_ELAPSED);
+      m_GpuOpen = false;
+    }
+  }
+  // Deletes the query objects; call before the context is destroyed.
+  void ReleaseGpu() {
+    if (m_GpuCreated) {
+      for (auto& Frame : m_Gpu) {
+        glDeleteQueries(static_cast<GLsizei>(kMaxGpuScopes),
+                        Frame.m_Queries.data());
+        Frame = {};
+      }
+    }
+    m_GpuCreated = false;
+    m_GpuOpen = false;
+  }
+
+  void BeginFrame() { m_FrameBegin = Now(); }
+  // Collects every scope finished since the last call (GPU scopes of the
+  // previous frame) and folds them into the statistics.
+  void EndFrame() {
+    m_LastFrame.clear();
+    {
+      std::scoped_lock const Lock{m_RingsMutex};
+      for (auto& Ring : m_Rings) {
+        Ring->Drain([this](ProfileSample const& sample) {
+          m_LastFrame.push_back(sample);
+        });
+      }
+    }
+    if (m_GpuCreated) {
+      CollectGpu();
+    }
+    if (!IsEnabled()) {
+      m_LastFrame.clear();
+      return;
+    }
+    auto const End = Now();
+    m_LastFrame.push_back({.m_Name = kFrameScope,
+                           .m_Begin = m_FrameBegin,
+                           .m_Duration = End - m_FrameBegin,
+                           .m_Thread = LocalRing().Thread()});
+    Aggregate();
+    ++m_Frames;
+  }
+
+  [[nodiscard]] auto Frames() const noexcept -> std::uint64_t {
+    return m_Frames;
+  }
+  // Samples gathered by the last EndFrame, CPU and GPU mixed.
+  [[nodiscard]] auto LastFrame() const noexcept
+      -> std::span<ProfileSample const> {
+    return m_LastFrame;
+  }
+  [[nodiscard]] auto Dropped() -> std::uint64_t {
+    std::scoped_lock const Lock{m_RingsMutex};
+    auto Total = m_GpuDropped;
+    for (auto const& Ring : m_Rings) {
+      Total += Ring->Dropped();
+    }
+    return Total;
+  }
+
+  [[nodiscard]] auto Stats(std::string_view name,
+                           SampleKind kind = SampleKind::kCpu) const
+      -> std::optional<ScopeStats> {
+    auto const Found = m_History.find({name, kind});
+    if (Found == m_History.end() || Found->second.m_Count == 0) {
+      return std::nullopt;
+    }
+    auto const& Entry = Found->second;
+    std::array<std::int64_t, kWindow> Sorted{};
+    auto const Values = std::span(Entry.m_Durations).first(Entry.m_Count);
+    std::ranges::copy(Values, Sorted.begin());
+    auto const Used = std::span(Sorted).first(Entry.m_Count);
+    std::ranges::sort(Used);
+    std::int64_t Sum{};
+    for (auto Value : Used) {
+      Sum += Value;
+    }
+    // nearest rank: the smallest value at or above 99% of the frames
+    auto const Rank = ((Entry.m_Count * 99) + 99) / 100;
+    constexpr auto kMs = 1e-6;
+    return ScopeStats{
+        .m_Name = Found->first.m_Name,
+        .m_Kind = kind,
+        .m_Frames = Entry.m_Count,
+        .m_MinMs = static_cast<double>(Used.front()) * kMs,
+        .m_AvgMs = static_cast<double>(Sum) * kMs /
+                   static_cast<double>(Entry.m_Count),
+        .m_P99Ms = static_cast<double>(Used[Rank - 1]) * kMs,
+        .m_MaxMs = static_cast<double>(Used.back()) * kMs};
+  }
+  // Every scope seen so far, slowest average first.
+  [[nodiscard]] auto Stats() const -> std::vector<ScopeStats> {
+    std::vector<ScopeStats> Result;
+    for (auto const& [Scope, Entry] : m_History) {
+      if (auto Found = Stats(Scope.m_Name, Scope.m_Kind)) {
+        Result.push_back(*Found);
+      }
+    }
+    std::ranges::sort(Result, std::ranges::greater{}, &ScopeStats::m_AvgMs);
+    return Result;
+  }
+  void LogSummary(
+      spdlog::level::level_enum level = spdlog::level::info) const {
+    if (!spdlog::should_log(level)) {
+      return;
+    }
+    for (auto const& Scope : Stats()) {
+      spdlog::log(level,
+                  "{} {:<24} min {:7.3f} ms  avg {:7.3f} ms  p99 {:7.3f} ms",
+                  Scope.m_Kind == SampleKind::kGpu ? "GPU" : "CPU",
+                  Scope.m_Name, Scope.m_MinMs, Scope.m_AvgMs, Scope.m_P99Ms);
+    }
+  }
+  // Forgets the statistics; rings and queries stay.
+  void Reset() {
+    m_History.clear();
+    m_LastFrame.clear();
+    m_Frames = 0;
+  }
+};
+
+// Times the enclosing block on the calling thread.
+class CpuScope {
+  char const* m_Name;
+  std::int64_t m_Begin;
+
+ public:
+  explicit CpuScope(char const* name) noexcept
+      : m_Name{name}, m_Begin{Profiler::Now()} {}
+  CpuScope(CpuScope const&) = delete;
+  auto operator=(CpuScope const&) -> CpuScope& = delete;
+  CpuScope(CpuScope&&) = delete;
+  auto operator=(CpuScope&&) -> CpuScope& = delete;
+  ~CpuScope() {
+    auto& Shared = Profiler::Instance();
+    if (Shared.IsEnabled()) {
+      Shared.RecordCpu(m_Name, m_Begin, Profiler::Now());
+    }
+  }
+};
+
+// Times the GL commands issued in the enclosing block on the GPU.
+class GpuScope {
+  bool m_Active;
+
+ public:
+  explicit GpuScope(char const* name)
+      : m_Active{Profiler::Instance().BeginGpu(name)} {}
+  GpuScope(GpuScope const&) = delete;
+  auto operator=(GpuScope const&) -> GpuScope& = delete;
+  GpuScope(GpuScope&&) = delete;
+  auto operator=(GpuScope&&) -> GpuScope& = delete;
+  ~GpuScope() {
+    if (m_Active) {
+      Profiler::Instance().EndGpu();
+    }
+  }
+};
+
+}  // namespace gl
+#endif
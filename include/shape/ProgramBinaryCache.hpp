@@ -0,0 +1,212 @@
+#ifndef SHAPE_PROGRAMBINARYCACHE_HPP
+#define SHAPE_PROGRAMBINARYCACHE_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <shape/Errors.hpp>
+#include <shape/Hash.hpp>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// Persists linked program binaries between runs. Entries are keyed by the
+// program's source hash and the driver vendor/renderer/version string; any
+// mismatch, truncation or driver rejection falls back to compiling from
+// source and the stale entry is overwritten.
+class ProgramBinaryCache {
+ public:
+  struct Stats {
+    std::size_t m_Loaded{};
+    std::size_t m_Missing{};
+    std::size_t m_Rejected{};
+    std::size_t m_Stored{};
+  };
+
+ private:
+  static constexpr std::uint32_t kMagic = 0x42505047;  // "GPPB"
+  static constexpr std::uint32_t kFileVersion = 1;
+  struct Header {
+    std::uint32_t m_Magic{kMagic};
+    std::uint32_t m_Version{kFileVersion};
+    std::uint64_t m_DriverKey{};
+    std::uint64_t m_SourceKey{};
+    std::uint64_t m_Checksum{};
+    std::uint32_t m_Format{};
+    std::uint32_t m_Length{};
+  };
+
+  std::filesystem::path m_Directory;
+  std::optional<std::uint64_t> m_DriverKey;
+  // false once the directory or the driver rules the cache out
+  bool m_Supported = true;
+  Stats m_Stats;
+
+  static auto Checksum(std::vector<char> const &bytes) -> std::uint64_t {
+    return HashBytes(std::string_view{bytes.data(), bytes.size()});
+  }
+  static auto GetString(GLenum name) -> std::string_view {
+    // NOLINTNEXTLINE
+    auto const *Value = reinterpret_cast<char const *>(glGetString(name));
+    return Value == nullptr ? std::string_view{} : std::string_view{Value};
+  }
+  // Needs a current context, so it is resolved on first use.
+  auto DriverKey() -> std::uint64_t {
+    if (!m_DriverKey) {
+      std::string Driver;
+      for (auto Name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        Driver += GetString(static_cast<GLenum>(Name));
+        Driver += '\n';
+      }
+      m_DriverKey = HashBytes(Driver);
+      GLint Formats = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &Formats);
+      if (Formats <= 0) {
+        spdlog::info("Program binaries unsupported by driver, cache disabled");
+      }
+      m_Supported = m_Supported && Formats > 0;
+    }
+    return *m_DriverKey;
+  }
+  // Resolves the driver key first, which may disable the cache.
+  auto IsUsable() -> bool {
+    if (m_Supported) {
+      DriverKey();
+    }
+    return m_Supported;
+  }
+  auto PathFor(std::uint64_t sourceKey) -> std::filesystem::path {
+    return m_Directory /
+           std::format("{:016x}-{:016x}.bin", sourceKey, DriverKey());
+  }
+  auto Reject(std::filesystem::path const &path, std::string_view reason)
+      -> std::optional<GLuint> {
+    spdlog::warn("Discarding cached program binary {}: {}", path.string(),
+                 reason);
+    ++m_Stats.m_Rejected;
+    std::error_code Ignored;
+    std::filesystem::remove(path, Ignored);
+    return std::nullopt;
+  }
+
+ public:
+  explicit ProgramBinaryCache(std::filesystem::path directory)
+      : m_Directory(std::move(directory)) {
+    std::error_code Error;
+    std::filesystem::create_directories(m_Directory, Error);
+    if (Error) {
+      spdlog::warn("Cannot create program cache directory {}: {}",
+                   m_Directory.string(), Error.message());
+      m_Supported = false;
+    }
+  }
+
+  [[nodiscard]] auto Directory() const -> std::filesystem::path const & {
+    return m_Directory;
+  }
+
+  // Returns a linked program when a valid binary for this driver exists.
+  auto Load(std::uint64_t sourceKey) -> std::optional<GLuint> {
+    if (!IsUsable()) {
+      return std::nullopt;
+    }
+    auto const Path = PathFor(sourceKey);
+    std::ifstream File(Path, std::ios::binary);
+    if (!File) {
+      ++m_Stats.m_Missing;
+      return std::nullopt;
+    }
+    Header Read{};
+    // NOLINTNEXTLINE
+    if (!File.read(reinterpret_cast<char *>(&Read), sizeof(Read))) {
+      return Reject(Path, "truncated header");
+    }
+    if (Read.m_Magic != kMagic || Read.m_Version != kFileVersion ||
+        Read.m_SourceKey != sourceKey || Read.m_DriverKey != DriverKey()) {
+      return Reject(Path, "header mismatch");
+    }
+    // the length is untrusted until checked against what the file holds
+    std::error_code SizeError;
+    auto const FileSize = std::filesystem::file_size(Path, SizeError);
+    if (SizeError || Read.m_Length > FileSize - sizeof(Read)) {
+      return Reject(Path, "binary length exceeds the file");
+    }
+    std::vector<char> Binary(Read.m_Length);
+    if (!File.read(Binary.data(), static_cast<std::streamsize>(Binary.size()))) {
+      return Reject(Path, "truncated binary");
+    }
+    if (Checksum(Binary) != Read.m_Checksum) {
+      return Reject(Path, "checksum mismatch");
+    }
+    auto Program = glCreateProgram();
+    glProgramBinary(Program, Read.m_Format, Binary.data(),
+                    static_cast<GLsizei>(Binary.size()));
+    GLint Linked = GL_FALSE;
+    glGetProgramiv(Program, GL_LINK_STATUS, &Linked);
+    if (Linked == GL_FALSE) {
+      glDeleteProgram(Program);
+      return Reject(Path, "driver rejected binary");
+    }
+    ++m_Stats.m_Loaded;
+    return Program;
+  }
+
+  // The program should have been linked with
+  // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+  void Store(std::uint64_t sourceKey, GLuint program) {
+    if (!IsUsable()) {
+      return;
+    }
+    auto const Path = PathFor(sourceKey);
+    GLint Length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &Length);
+    if (Length <= 0) {
+      return;
+    }
+    std::vector<char> Binary(static_cast<std::size_t>(Length));
+    GLenum Format = 0;
+    glGetProgramBinary(program, Length, &Length, &Format, Binary.data());
+    Binary.resize(static_cast<std::size_t>(Length));
+    Header Written{.m_DriverKey = DriverKey(),
+                   .m_SourceKey = sourceKey,
+                   .m_Checksum = Checksum(Binary),
+                   .m_Format = Format,
+                   .m_Length = static_cast<std::uint32_t>(Binary.size())};
+    // write then rename so a crash never leaves a half-written entry behind
+    auto Temporary = Path;
+    Temporary += ".tmp";
+    {
+      std::ofstream File(Temporary, std::ios::binary | std::ios::trunc);
+      // NOLINTNEXTLINE
+      File.write(reinterpret_cast<char const *>(&Written), sizeof(Written));
+      File.write(Binary.data(), static_cast<std::streamsize>(Binary.size()));
+      if (!File) {
+        spdlog::warn("Failed writing program binary {}", Temporary.string());
+        return;
+      }
+    }
+    std::error_code Error;
+    std::filesystem::rename(Temporary, Path, Error);
+    if (Error) {
+      spdlog::warn("Failed storing program binary {}: {}", Path.string(),
+                   Error.message());
+      std::filesystem::remove(Temporary, Error);
+      return;
+    }
+    ++m_Stats.m_Stored;
+  }
+
+  [[nodiscard]] auto GetStats() const noexcept -> Stats { return m_Stats; }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,317 @@
+#ifndef SHAPE_QUADBATCH_HPP
+#define SHAPE_QUADBATCH_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <shape/Buffer.hpp>
+#include <shape/Errors.hpp>
+#include <shape/FrameStats.hpp>
+#include <shape/Point.hpp>
+#include <shape/RenderQueue.hpp>
+#include <shape/ShaderCache.hpp>
+#include <shape/StateCache.hpp>
+#include <shape/Vector.hpp>
+#include <shape/VertexArray.hpp>
+#include <shape/VertexStream.hpp>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+namespace gl {
+
+constexpr auto kDefaultVertexShader =
+    R"(#version 330 core
+layout (location = 0) in vec3 aPos;   // the position variable has attribute position 0
+layout (location = 1) in vec4 aColor; // the color variable has attribute position 1
+
+out vec4 ourColor; // output a color to the fragment shader
+uniform vec4 offset;
+
+void main()
+{
+    gl_Position = vec4(aPos, 1.0) + offset;
+    ourColor = aColor; // set ourColor to the input color we got from the vertex data
+}
+)";
+constexpr auto kDefaultFragmentShader =
+    R"(#version 330 core
+out vec4 FragColor;
+in vec4 ourColor;
+
+void main()
+{
+    FragColor = ourColor;
+}
+)";
+
+// Accumulates quads of every material into one vertex/index stream per
+// material, so a frame costs one glDrawElements per material instead of one
+// per quad. Per-quad offsets are baked into the vertices on the CPU. Positions
+// and colors live in separate buffers, and only the range of quads touched
+// since the last Draw is re-uploaded; moving a quad never re-sends its colors.
+class QuadBatch {
+ public:
+  using MaterialId = std::uint32_t;
+  // Quad ids are reused after Remove; the generation tells a stale handle
+  // from the one of the quad that took its id.
+  struct Handle {
+    MaterialId m_Material{};
+    std::uint32_t m_Quad{std::numeric_limits<std::uint32_t>::max()};
+    std::uint32_t m_Generation{};
+  };
+  static constexpr MaterialId kDefaultMaterial = 0;
+  static constexpr auto kVerticesPerQuad = 4UZ;
+  static constexpr auto kIndicesPerQuad = 6UZ;
+
+ private:
+  static constexpr auto kNoSlot = std::numeric_limits<std::uint32_t>::max();
+  static constexpr auto kInitialCapacity = 64UZ;
+
+  struct Material {
+    gl::ProgramHandle m_Program;
+    GLint m_OffsetLocation{-1};
+    // kVerticesPerQuad entries per slot: position, color
+    VertexStream<gl::Vector3<float>, gl::ColorFloat> m_Vertices{
+        Interleaving::kSeparate, {0U, 1U}};
+    gl::Buffer<BufferType::kElementArray> m_Indices;
+    std::size_t m_Capacity{};  // in quads, of the index buffer
+    std::vector<std::array<gl::Point, kVerticesPerQuad>> m_BasePositions;
+    std::vector<gl::Vector4<float>> m_Offsets;
+    // quad id -> slot and slot -> quad id, slots stay densely packed
+    std::vector<std::uint32_t> m_SlotOfQuad;
+    std::vector<std::uint32_t> m_QuadOfSlot;
+    std::vector<std::uint32_t> m_FreeQuads;
+    // quad id -> generation, bumped whenever the id is freed
+    std::vector<std::uint32_t> m_Generations;
+  };
+  std::vector<Material> m_Materials;
+
+  // The slot of a live handle, kNoSlot for stale or foreign ones.
+  [[nodiscard]] auto SlotOf(Handle handle) const noexcept -> std::uint32_t {
+    if (handle.m_Material >= m_Materials.size()) {
+      return kNoSlot;
+    }
+    auto const& Target = m_Materials[handle.m_Material];
+    if (handle.m_Quad >= Target.m_SlotOfQuad.size() ||
+        Target.m_Generations[handle.m_Quad] != handle.m_Generation) {
+      return kNoSlot;
+    }
+    return Target.m_SlotOfQuad[handle.m_Quad];
+  }
+  [[nodiscard]] auto CheckedSlotOf(Handle handle) const -> std::uint32_t {
+    auto const Slot = SlotOf(handle);
+    if (Slot == kNoSlot) {
+      throw std::invalid_argument("QuadBatch: stale quad handle");
+    }
+    return Slot;
+  }
+
+  static void WritePositions(Material& material, std::size_t slot) {
+    auto const& Base = material.m_BasePositions[slot];
+    auto Offset = material.m_Offsets[slot];
+    auto const Delta =
+        gl::Vector3<float>{{Offset.X(), Offset.Y(), Offset.Z()}};
+    std::array<gl::Vector3<float>, kVerticesPerQuad> Positions{};
+    for (auto Vertex = 0UZ; Vertex < kVerticesPerQuad; ++Vertex) {
+      Positions.at(Vertex) = Base.at(Vertex).m_Position + Delta;
+    }
+    material.m_Vertices.Write<0>(slot * kVerticesPerQuad, Positions);
+  }
+  static void WriteColors(Material& material, std::size_t slot) {
+    auto const& Base = material.m_BasePositions[slot];
+    std::array<gl::ColorFloat, kVerticesPerQuad> Colors{};
+    for (auto Vertex = 0UZ; Vertex < kVerticesPerQuad; ++Vertex) {
+      Colors.at(Vertex) = Base.at(Vertex).m_Color;
+    }
+    material.m_Vertices.Write<1>(slot * kVerticesPerQuad, Colors);
+  }
+  static void WriteSlot(Material& material, std::size_t slot) {
+    WritePositions(material, slot);
+    WriteColors(material, slot);
+  }
+  static void Reserve(Material& material, std::size_t quads) {
+    if (quads <= material.m_Capacity) {
+      return;
+    }
+    auto NewCapacity = std::max(material.m_Capacity, kInitialCapacity);
+    while (NewCapacity < quads) {
+      NewCapacity *= 2;
+    }
+    std::vector<GLuint> Indices(NewCapacity * kIndicesPerQuad);
+    constexpr auto kPattern = std::array{0U, 1U, 2U, 0U, 2U, 3U};
+    for (auto Quad = 0UZ; Quad < NewCapacity; ++Quad) {
+      for (auto Index = 0UZ; Index < kIndicesPerQuad; ++Index) {
+        Indices[(Quad * kIndicesPerQuad) + Index] = static_cast<GLuint>(
+            (Quad * kVerticesPerQuad) + kPattern.at(Index));
+      }
+    }
+    material.m_Indices.Data(Indices, Usage::kStaticDraw);
+    material.m_Capacity = NewCapacity;
+  }
+  static void Upload(Material& material) {
+    Reserve(material, material.m_QuadOfSlot.size());
+    material.m_Vertices.Upload();
+  }
+
+ public:
+  QuadBatch() {
+    auto Result = AddMaterial(kDefaultVertexShader, kDefaultFragmentShader);
+    if (!Result) {
+      Result.error().Handle();
+    }
+  }
+  QuadBatch(QuadBatch const&) = delete;
+  auto operator=(QuadBatch const&) -> QuadBatch& = delete;
+  QuadBatch(QuadBatch&&) = delete;
+  auto operator=(QuadBatch&&) -> QuadBatch& = delete;
+  ~QuadBatch() = default;
+
+  // Every material is drawn with its own program; the shaders must accept
+  // the gl::Point layout (location 0: vec3 position, location 1: vec4 color).
+  auto AddMaterial(std::string_view vertexShader,
+                   std::string_view fragmentShader)
+      -> gl::errors::Expected<MaterialId> {
+    auto Program = ShaderCache::Instance().Get(vertexShader, fragmentShader);
+    if (!Program) {
+      return std::unexpected(Program.error());
+    }
+    auto& Added = m_Materials.emplace_back();
+    Added.m_Program = *std::move(Program);
+    Added.m_OffsetLocation =
+        glGetUniformLocation(Added.m_Program->Get(), "offset");
+    Added.m_Vertices.Array().ElementBuffer(Added.m_Indices.Get());
+    return static_cast<MaterialId>(m_Materials.size() - 1);
+  }
+
+  auto Add(std::array<gl::Point, kVerticesPerQuad> const& positions,
+           MaterialId material = kDefaultMaterial) -> Handle {
+    auto& Target = m_Materials.at(material);
+    std::uint32_t Quad{};
+    if (Target.m_FreeQuads.empty()) {
+      Quad = static_cast<std::uint32_t>(Target.m_SlotOfQuad.size());
+      Target.m_SlotOfQuad.push_back(kNoSlot);
+      Target.m_Generations.push_back(0);
+    } else {
+      Quad = Target.m_FreeQuads.back();
+      Target.m_FreeQuads.pop_back();
+    }
+    auto const Slot = Target.m_QuadOfSlot.size();
+    Target.m_SlotOfQuad[Quad] = static_cast<std::uint32_t>(Slot);
+    Target.m_QuadOfSlot.push_back(Quad);
+    Target.m_BasePositions.push_back(positions);
+    Target.m_Offsets.emplace_back();
+    Target.m_Vertices.Resize(Target.m_Vertices.Size() + kVerticesPerQuad);
+    WriteSlot(Target, Slot);
+    return Handle{.m_Material = material,
+                  .m_Quad = Quad,
+                  .m_Generation = Target.m_Generations[Quad]};
+  }
+
+  // Returns false, and changes nothing, for a stale handle.
+  auto Remove(Handle handle) -> bool {
+    auto const Slot = SlotOf(handle);
+    if (Slot == kNoSlot) {
+      return false;
+    }
+    auto& Target = m_Materials[handle.m_Material];
+    auto const Last = Target.m_QuadOfSlot.size() - 1;
+    if (Slot != Last) {
+      // keep the stream dense by moving the last quad into the hole
+      auto const Moved = Target.m_QuadOfSlot[Last];
+      Target.m_BasePositions[Slot] = Target.m_BasePositions[Last];
+      Target.m_Offsets[Slot] = Target.m_Offsets[Last];
+      Target.m_QuadOfSlot[Slot] = Moved;
+      Target.m_SlotOfQuad[Moved] = Slot;
+      WriteSlot(Target, Slot);
+    }
+    Target.m_BasePositions.pop_back();
+    Target.m_Offsets.pop_back();
+    Target.m_QuadOfSlot.pop_back();
+    Target.m_Vertices.Resize(Target.m_Vertices.Size() - kVerticesPerQuad);
+    Target.m_SlotOfQuad[handle.m_Quad] = kNoSlot;
+    ++Target.m_Generations[handle.m_Quad];
+    Target.m_FreeQuads.push_back(handle.m_Quad);
+    return true;
+  }
+
+  [[nodiscard]] auto Contains(Handle handle) const noexcept -> bool {
+    return SlotOf(handle) != kNoSlot;
+  }
+
+  void SetPositions(Handle handle,
+                    std::array<gl::Point, kVerticesPerQuad> const& positions) {
+    auto const Slot = CheckedSlotOf(handle);
+    auto& Target = m_Materials[handle.m_Material];
+    Target.m_BasePositions[Slot] = positions;
+    WriteSlot(Target, Slot);
+  }
+  void SetOffset(Handle handle, gl::Vector4<float> offset) {
+    auto const Slot = CheckedSlotOf(handle);
+    auto& Target = m_Materials[handle.m_Material];
+    Target.m_Offsets[Slot] = offset;
+    WritePositions(Target, Slot);
+  }
+  [[nodiscard]] auto GetOffset(Handle handle) const -> gl::Vector4<float> {
+    auto const Slot = CheckedSlotOf(handle);
+    return m_Materials[handle.m_Material].m_Offsets[Slot];
+  }
+  [[nodiscard]] auto Size(MaterialId material = kDefaultMaterial) const
+      -> std::size_t {
+    return m_Materials.at(material).m_QuadOfSlot.size();
+  }
+
+  // Uploads what changed since the last call and submits one draw per
+  // non-empty material.
+  void Enqueue(RenderQueue& queue, std::uint8_t layer = 0,
+               bool translucent = false, float depth = 0.0F) {
+    for (auto& Entry : m_Materials) {
+      if (Entry.m_QuadOfSlot.empty()) {
+        continue;
+      }
+      Upload(Entry);
+      auto const Program = Entry.m_Program->Get();
+      auto const VertexArray = Entry.m_Vertices.Array().Get().value_or(0);
+      queue.Submit(DrawCommand{
+          .m_Key = translucent ? sort_key::Translucent(layer, Program,
+                                                       VertexArray, depth)
+                               : sort_key::Opaque(layer, Program, VertexArray,
+                                                  depth),
+          .m_Program = Program,
+          .m_VertexArray = VertexArray,
+          .m_Count = static_cast<GLsizei>(Entry.m_QuadOfSlot.size() *
+                                          kIndicesPerQuad),
+          .m_UniformLocation = Entry.m_OffsetLocation});
+    }
+  }
+
+  // Uploads what changed since the last call and issues one draw per
+  // non-empty material.
+  void Draw() {
+    for (auto& Entry : m_Materials) {
+      if (Entry.m_QuadOfSlot.empty()) {
+        continue;
+      }
+      Upload(Entry);
+      auto& State = StateCache::Instance();
+      State.UseProgram(Entry.m_Program->Get());
+      // offsets are baked into the vertices; the program may be shared with
+      // users of the uniform, so reset it on every draw
+      State.Uniform4f(Entry.m_OffsetLocation, 0.0F, 0.0F, 0.0F, 0.0F);
+      (void)Entry.m_Vertices.Array().Bind();
+      auto const Count = Entry.m_QuadOfSlot.size() * kIndicesPerQuad;
+      FrameStats::Instance().CountDraw(TriangleCount(GL_TRIANGLES, Count));
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(Count),
+                     GL_UNSIGNED_INT, nullptr);
+    }
+  }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,403 @@
+#ifndef SHAPE_RECORDINGBACKEND_HPP
+#define SHAPE_RECORDINGBACKEND_HPP
+#include <glad/glad.h>  //
+//
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <shape/StateCache.hpp>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// One intercepted GL call. Integers, enums and names are stored as is,
+// pointers as addresses and floats bit-cast (read them back with Float()).
+struct Command {
+  std::string_view m_Name;
+  std::vector<std::int64_t> m_Args;
+  std::size_t m_Bytes{};  // bytes handed to the driver by uploads
+
+  [[nodiscard]] auto Float(std::size_t index) const -> float {
+    return std::bit_cast<float>(static_cast<std::int32_t>(m_Args.at(index)));
+  }
+};
+
+class CommandLog {
+  std::vector<Command> m_Commands;
+
+ public:
+  void Record(Command command) { m_Commands.push_back(std::move(command)); }
+  void Clear() noexcept { m_Commands.clear(); }
+
+  [[nodiscard]] auto All() const noexcept -> std::span<Command const> {
+    return m_Commands;
+  }
+  [[nodiscard]] auto Count(std::string_view name) const -> std::size_t {
+    return static_cast<std::size_t>(
+        std::ranges::count(m_Commands, name, &Command::m_Name));
+  }
+  // Every glDraw* and glMultiDraw* call.
+  [[nodiscard]] auto DrawCalls() const -> std::size_t {
+    return static_cast<std::size_t>(
+        std::ranges::count_if(m_Commands, [](Command const& Entry) -> bool {
+          return Entry.m_Name.starts_with("glDraw") ||
+                 Entry.m_Name.starts_with("glMultiDraw");
+        }));
+  }
+  [[nodiscard]] auto UploadBytes() const -> std::size_t {
+    auto Total = 0UZ;
+    for (auto const& Entry : m_Commands) {
+      Total += Entry.m_Bytes;
+    }
+    return Total;
+  }
+  // Most recent call of that name, nullptr when there is none.
+  [[nodiscard]] auto Last(std::string_view name) const -> Command const* {
+    auto Found = std::ranges::find(m_Commands.rbegin(), m_Commands.rend(),
+                                   name, &Command::m_Name);
+    return Found == m_Commands.rend() ? nullptr : &*Found;
+  }
+};
+
+namespace recording {
+
+template <std::size_t N>
+struct Name {
+  std::array<char, N> m_Value{};
+  // NOLINTNEXTLINE
+  consteval Name(char const (&value)[N]) {
+    std::copy_n(value, N, m_Value.begin());
+  }
+  [[nodiscard]] constexpr auto View() const -> std::string_view {
+    return {m_Value.data(), N - 1};
+  }
+};
+
+// State shared by the hooks while a RecordingBackend is alive.
+struct Session {
+  CommandLog m_Log;
+  bool m_Forward = false;
+  GLuint m_NextName = 1;
+  std::uintptr_t m_NextSync = 1;
+  std::unordered_map<GLenum, GLuint> m_Bindings;
+  // contents of every buffer specified without a driver behind us
+  std::unordered_map<GLuint, std::vector<std::byte>> m_Storage;
+};
+inline auto Current() -> Session*& {
+  static Session* Active = nullptr;
+  return Active;
+}
+
+template <typename T>
+auto ToArg(T value) -> std::int64_t {
+  if constexpr (std::is_pointer_v<T>) {
+    // NOLINTNEXTLINE
+    return reinterpret_cast<std::intptr_t>(value);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return std::bit_cast<std::int32_t>(static_cast<float>(value));
+  } else {
+    return static_cast<std::int64_t>(value);
+  }
+}
+
+// Without a driver: names are handed out from a counter, buffer contents are
+// kept on the CPU so mapped pointers stay writable, and every query reports
+// success.
+namespace mock {
+inline void APIENTRY GenNames(GLsizei count, GLuint* names) {
+  for (auto& Name : std::span(names, static_cast<std::size_t>(count))) {
+    Name = Current()->m_NextName++;
+  }
+}
+inline auto APIENTRY CreateName() -> GLuint { return Current()->m_NextName++; }
+inline auto APIENTRY CreateShader(GLenum /*type*/) -> GLuint {
+  return CreateName();
+}
+inline void APIENTRY DeleteBuffers(GLsizei count, GLuint const* names) {
+  for (auto Name : std::span(names, static_cast<std::size_t>(count))) {
+    Current()->m_Storage.erase(Name);
+  }
+}
+inline void APIENTRY BindBuffer(GLenum target, GLuint buffer) {
+  Current()->m_Bindings[target] = buffer;
+}
+inline void Specify(GLuint buffer, GLsizeiptr size, void const* data) {
+  auto& Storage = Current()->m_Storage[buffer];
+  Storage.assign(static_cast<std::size_t>(size), std::byte{});
+  if (data != nullptr && size > 0) {
+    std::memcpy(Storage.data(), data, Storage.size());
+  }
+}
+inline void Update(GLuint buffer, GLintptr offset, GLsizeiptr size,
+                   void const* data) {
+  auto& Storage = Current()->m_Storage[buffer];
+  auto const End = static_cast<std::size_t>(offset + size);
+  if (data != nullptr && size > 0 && End <= Storage.size()) {
+    std::memcpy(Storage.data() + offset, data, static_cast<std::size_t>(size));
+  }
+}
+inline void APIENTRY NamedBufferData(GLuint buffer, GLsizeiptr size,
+                                     void const* data, GLenum /*usage*/) {
+  Specify(buffer, size, data);
+}
+inline void APIENTRY NamedBufferStorage(GLuint buffer, GLsizeiptr size,
+                                        void const* data, GLbitfield /*flags*/) {
+  Specify(buffer, size, data);
+}
+inline void APIENTRY NamedBufferSubData(GLuint buffer, GLintptr offset,
+                                        GLsizeiptr size, void const* data) {
+  Update(buffer, offset, size, data);
+}
+inline void APIENTRY BufferData(GLenum target, GLsizeiptr size,
+                                void const* data, GLenum /*usage*/) {
+  Specify(Current()->m_Bindings[target], size, data);
+}
+inline void APIENTRY BufferSubData(GLenum target, GLintptr offset,
+                                   GLsizeiptr size, void const* data) {
+  Update(Current()->m_Bindings[target], offset, size, data);
+}
+inline auto APIENTRY MapNamedBufferRange(GLuint buffer, GLintptr offset,
+                                         GLsizeiptr /*length*/,
+                                         GLbitfield /*access*/) -> void* {
+  return Current()->m_Storage[buffer].data() + offset;
+}
+inline auto APIENTRY UnmapNamedBuffer(GLuint /*buffer*/) -> GLboolean {
+  return GL_TRUE;
+}
+inline auto APIENTRY FenceSync(GLenum /*condition*/, GLbitfield /*flags*/)
+    -> GLsync {
+  // NOLINTNEXTLINE
+  return reinterpret_cast<GLsync>(Current()->m_NextSync++);
+}
+inline auto APIENTRY ClientWaitSync(GLsync /*sync*/, GLbitfield /*flags*/,
+                                    GLuint64 /*timeout*/) -> GLenum {
+  return GL_ALREADY_SIGNALED;
+}
+inline void APIENTRY GetShaderiv(GLuint /*shader*/, GLenum name,
+                                 GLint* value) {
+  *value = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+inline void APIENTRY GetProgramiv(GLuint /*program*/, GLenum name,
+                                  GLint* value) {
+  *value = (name == GL_LINK_STATUS || name == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+inline void APIENTRY GetInfoLog(GLuint /*object*/, GLsizei size,
+                                GLsizei* length, GLchar* log) {
+  if (length != nullptr) {
+    *length = 0;
+  }
+  if (log != nullptr && size > 0) {
+    *log = '\0';
+  }
+}
+inline auto APIENTRY GetString(GLenum /*name*/) -> GLubyte const* {
+  // NOLINTNEXTLINE
+  return reinterpret_cast<GLubyte const*>("recording");
+}
+inline void APIENTRY GetIntegerv(GLenum /*name*/, GLint* value) { *value = 0; }
+// queries finish immediately and measure nothing
+inline void APIENTRY GetQueryObjectiv(GLuint /*query*/, GLenum name,
+                                      GLint* value) {
+  *value = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+inline void APIENTRY GetQueryObjectui64v(GLuint /*query*/, GLenum /*name*/,
+                                         GLuint64* value) {
+  *value = 0;
+}
+}  // namespace mock
+
+template <typename... Args>
+auto HasData(Args... args) -> bool {
+  return ([](auto Value) -> bool {
+    if constexpr (std::is_pointer_v<decltype(Value)>) {
+      return Value != nullptr;
+    } else {
+      return false;
+    }
+  }(args) || ...);
+}
+
+template <typename Function, auto& Slot, Name CommandName, auto Mock,
+          int BytesArg>
+struct HookImpl;
+template <typename Result, typename... Args, auto& Slot, Name CommandName,
+          auto Mock, int BytesArg>
+struct HookImpl<Result(APIENTRYP)(Args...), Slot, CommandName, Mock,
+                BytesArg> {
+  static inline Result(APIENTRYP s_Saved)(Args...) = nullptr;
+
+  static auto APIENTRY Call(Args... args) -> Result {
+    auto* Active = Current();
+    auto Bytes = 0UZ;
+    if constexpr (BytesArg >= 0) {
+      // allocations without a data pointer do not transfer anything
+      if (HasData(args...)) {
+        Bytes =
+            static_cast<std::size_t>(std::get<BytesArg>(std::tuple{args...}));
+      }
+    }
+    Active->m_Log.Record({.m_Name = CommandName.View(),
+                          .m_Args = {ToArg(args)...},
+                          .m_Bytes = Bytes});
+    if (Active->m_Forward && s_Saved != nullptr) {
+      return s_Saved(args...);
+    }
+    if constexpr (!std::is_null_pointer_v<decltype(Mock)>) {
+      return Mock(args...);
+    } else if constexpr (!std::is_void_v<Result>) {
+      return Result{};
+    }
+  }
+  static void Install() {
+    s_Saved = Slot;
+    Slot = &Call;
+  }
+  static void Restore() { Slot = s_Saved; }
+};
+template <auto& Slot, Name CommandName, auto Mock = nullptr, int BytesArg = -1>
+using Hook = HookImpl<std::remove_reference_t<decltype(Slot)>, Slot,
+                      CommandName, Mock, BytesArg>;
+
+template <typename... Hooks>
+struct HookSet {
+  static void Install() { (Hooks::Install(), ...); }
+  static void Restore() { (Hooks::Restore(), ...); }
+};
+
+// Every entry point the shape headers and the sample application use.
+using AllHooks = HookSet<
+    Hook<glad_glGenBuffers, "glGenBuffers", &mock::GenNames>,
+    Hook<glad_glCreateBuffers, "glCreateBuffers", &mock::GenNames>,
+    Hook<glad_glDeleteBuffers, "glDeleteBuffers", &mock::DeleteBuffers>,
+    Hook<glad_glBindBuffer, "glBindBuffer", &mock::BindBuffer>,
+    Hook<glad_glBufferData, "glBufferData", &mock::BufferData, 1>,
+    Hook<glad_glBufferSubData, "glBufferSubData", &mock::BufferSubData, 2>,
+    Hook<glad_glNamedBufferData, "glNamedBufferData", &mock::NamedBufferData,
+         1>,
+    Hook<glad_glNamedBufferSubData, "glNamedBufferSubData",
+         &mock::NamedBufferSubData, 2>,
+    Hook<glad_glNamedBufferStorage, "glNamedBufferStorage",
+         &mock::NamedBufferStorage, 1>,
+    Hook<glad_glMapNamedBufferRange, "glMapNamedBufferRange",
+         &mock::MapNamedBufferRange>,
+    Hook<glad_glUnmapNamedBuffer, "glUnmapNamedBuffer",
+         &mock::UnmapNamedBuffer>,
+    Hook<glad_glGenVertexArrays, "glGenVertexArrays", &mock::GenNames>,
+    Hook<glad_glCreateVertexArrays, "glCreateVertexArrays", &mock::GenNames>,
+    Hook<glad_glDeleteVertexArrays, "glDeleteVertexArrays">,
+    Hook<glad_glBindVertexArray, "glBindVertexArray">,
+    Hook<glad_glVertexArrayVertexBuffer, "glVertexArrayVertexBuffer">,
+    Hook<glad_glVertexArrayElementBuffer, "glVertexArrayElementBuffer">,
+    Hook<glad_glVertexArrayAttribFormat, "glVertexArrayAttribFormat">,
+    Hook<glad_glVertexArrayAttribIFormat, "glVertexArrayAttribIFormat">,
+    Hook<glad_glVertexArrayAttribBinding, "glVertexArrayAttribBinding">,
+    Hook<glad_glVertexArrayBindingDivisor, "glVertexArrayBindingDivisor">,
+    Hook<glad_glEnableVertexArrayAttrib, "glEnableVertexArrayAttrib">,
+    Hook<glad_glCreateShader, "glCreateShader", &mock::CreateShader>,
+    Hook<glad_glShaderSource, "glShaderSource">,
+    Hook<glad_glCompileShader, "glCompileShader">,
+    Hook<glad_glGetShaderiv, "glGetShaderiv", &mock::GetShaderiv>,
+    Hook<glad_glGetShaderInfoLog, "glGetShaderInfoLog", &mock::GetInfoLog>,
+    Hook<glad_glDeleteShader, "glDeleteShader">,
+    Hook<glad_glCreateProgram, "glCreateProgram", &mock::CreateName>,
+    Hook<glad_glAttachShader, "glAttachShader">,
+    Hook<glad_glLinkProgram, "glLinkProgram">,
+    Hook<glad_glValidateProgram, "glValidateProgram">,
+    Hook<glad_glGetProgramiv, "glGetProgramiv", &mock::GetProgramiv>,
+    Hook<glad_glGetProgramInfoLog, "glGetProgramInfoLog", &mock::GetInfoLog>,
+    Hook<glad_glProgramParameteri, "glProgramParameteri">,
+    Hook<glad_glGetProgramBinary, "glGetProgramBinary">,
+    Hook<glad_glProgramBinary, "glProgramBinary", nullptr, 3>,
+    Hook<glad_glDeleteProgram, "glDeleteProgram">,
+    Hook<glad_glUseProgram, "glUseProgram">,
+    Hook<glad_glGetUniformLocation, "glGetUniformLocation">,
+    Hook<glad_glUniform4f, "glUniform4f">,
+    Hook<glad_glFenceSync, "glFenceSync", &mock::FenceSync>,
+    Hook<glad_glClientWaitSync, "glClientWaitSync", &mock::ClientWaitSync>,
+    Hook<glad_glDeleteSync, "glDeleteSync">,
+    Hook<glad_glEnable, "glEnable">, Hook<glad_glDisable, "glDisable">,
+    Hook<glad_glBlendFunc, "glBlendFunc">,
+    Hook<glad_glViewport, "glViewport">,
+    Hook<glad_glClearColor, "glClearColor">, Hook<glad_glClear, "glClear">,
+    Hook<glad_glDrawArrays, "glDrawArrays">,
+    Hook<glad_glDrawElements, "glDrawElements">,
+    Hook<glad_glDrawElementsBaseVertex, "glDrawElementsBaseVertex">,
+    Hook<glad_glDrawElementsInstanced, "glDrawElementsInstanced">,
+    Hook<glad_glDrawElementsInstancedBaseVertex,
+         "glDrawElementsInstancedBaseVertex">,
+    Hook<glad_glMultiDrawElementsIndirect, "glMultiDrawElementsIndirect">,
+    Hook<glad_glGetString, "glGetString", &mock::GetString>,
+    Hook<glad_glGetIntegerv, "glGetIntegerv", &mock::GetIntegerv>,
+    Hook<glad_glGenQueries, "glGenQueries", &mock::GenNames>,
+    Hook<glad_glDeleteQueries, "glDeleteQueries">,
+    Hook<glad_glBeginQuery, "glBeginQuery">,
+    Hook<glad_glEndQuery, "glEndQuery">,
+    Hook<glad_glGetQueryObjectiv, "glGetQueryObjectiv",
+         &mock::GetQueryObjectiv>,
+    Hook<glad_glGetQueryObjectui64v, "glGetQueryObjectui64v",
+         &mock::GetQueryObjectui64v>,
+    Hook<glad_glGetError, "glGetError">>;
+
+}  // namespace recording
+
+// Swaps the loaded GL entry points for recording ones for its lifetime, so
+// draw-call counts and upload volumes can be asserted on deterministically.
+// In kMock mode no context is needed and nothing reaches a driver; kForward
+// records and then calls through to the functions loaded before (e.g. a
+// HeadlessContext). Only one may be alive at a time, and only on the thread
+// owning the context.
+class RecordingBackend {
+ public:
+  // NOLINTNEXTLINE
+  enum struct Mode { kMock, kForward };
+
+ private:
+  recording::Session m_Session;
+
+ public:
+  explicit RecordingBackend(Mode mode = Mode::kMock) {
+    if (recording::Current() != nullptr) {
+      throw std::logic_error("A RecordingBackend is already active");
+    }
+    recording::Current() = &m_Session;
+    m_Session.m_Forward = mode == Mode::kForward;
+    recording::AllHooks::Install();
+    StateCache::Instance().Invalidate();
+  }
+  RecordingBackend(RecordingBackend const&) = delete;
+  auto operator=(RecordingBackend const&) -> RecordingBackend& = delete;
+  RecordingBackend(RecordingBackend&&) = delete;
+  auto operator=(RecordingBackend&&) -> RecordingBackend& = delete;
+  ~RecordingBackend() {
+    recording::AllHooks::Restore();
+    recording::Current() = nullptr;
+    StateCache::Instance().Invalidate();
+  }
+
+  [[nodiscard]] auto Log() noexcept -> CommandLog& { return m_Session.m_Log; }
+  [[nodiscard]] auto Log() const noexcept -> CommandLog const& {
+    return m_Session.m_Log;
+  }
+  // Contents of a buffer as last specified, only tracked in kMock mode.
+  [[nodiscard]] auto BufferContents(GLuint buffer) const
+      -> std::span<std::byte const> {
+    auto Found = m_Session.m_Storage.find(buffer);
+    if (Found == m_Session.m_Storage.end()) {
+      return {};
+    }
+    return Found->second;
+  }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,173 @@
+#ifndef SHAPE_RENDERQUEUE_HPP
+#define SHAPE_RENDERQUEUE_HPP
+#include <glad/glad.h>  //
+//
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <shape/FrameStats.hpp>
+#include <shape/StateCache.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// 64-bit draw sort key, most significant bits first:
+//   opaque:      layer:4 | 0 | program:16 | vertex array:16 | depth:24 | 0:3
+//   translucent: layer:4 | 1 | far-to-near depth:24 | program:16 | vao:16 | 0:3
+// Opaque draws group by state and go front to back inside a state; translucent
+// draws are strictly back to front and only then grouped by state. Layers go
+// up to 15, and program and vertex array names must fit 16 bits, or
+// different names would share a key; both are asserted.
+namespace sort_key {
+constexpr auto kLayerBits = 4U;
+constexpr auto kNameBits = 16U;
+constexpr auto kDepthBits = 24U;
+constexpr auto kLayerShift = 60U;
+constexpr auto kTranslucentShift = 59U;
+constexpr std::uint64_t kNameMask = (1ULL << kNameBits) - 1;
+constexpr std::uint64_t kDepthMask = (1ULL << kDepthBits) - 1;
+
+// Maps depth in [0, 1] (0 nearest) to an unsigned fixed point value; values
+// outside are clamped and NaN counts as nearest.
+constexpr auto QuantizeDepth(float depth) -> std::uint64_t {
+  // also false for NaN, which must not reach the integer conversion
+  if (!(depth > 0.0F)) {
+    return 0;
+  }
+  if (depth >= 1.0F) {
+    return kDepthMask;
+  }
+  return static_cast<std::uint64_t>(depth * static_cast<float>(kDepthMask));
+}
+constexpr void CheckRanges([[maybe_unused]] std::uint8_t layer,
+                           [[maybe_unused]] GLuint program,
+                           [[maybe_unused]] GLuint vertexArray) {
+  assert(layer < (1U << kLayerBits) && "sort keys hold 16 layers");
+  assert(program <= kNameMask && vertexArray <= kNameMask &&
+         "sort keys hold 16 bit program and vertex array names");
+}
+constexpr auto Opaque(std::uint8_t layer, GLuint program, GLuint vertexArray,
+                      float depth) -> std::uint64_t {
+  CheckRanges(layer, program, vertexArray);
+  return (static_cast<std::uint64_t>(layer) << kLayerShift) |
+         ((program & kNameMask) << 43U) | ((vertexArray & kNameMask) << 27U) |
+         (QuantizeDepth(depth) << 3U);
+}
+constexpr auto Translucent(std::uint8_t layer, GLuint program,
+                           GLuint vertexArray, float depth) -> std::uint64_t {
+  CheckRanges(layer, program, vertexArray);
+  return (static_cast<std::uint64_t>(layer) << kLayerShift) |
+         (1ULL << kTranslucentShift) |
+         ((kDepthMask - QuantizeDepth(depth)) << 35U) |
+         ((program & kNameMask) << 19U) | ((vertexArray & kNameMask) << 3U);
+}
+constexpr auto IsTranslucent(std::uint64_t key) -> bool {
+  return ((key >> kTranslucentShift) & 1U) != 0;
+}
+}  // namespace sort_key
+
+struct DrawCommand {
+  std::uint64_t m_Key{};
+  GLuint m_Program{};
+  GLuint m_VertexArray{};
+  GLenum m_Mode{GL_TRIANGLES};
+  GLsizei m_Count{};
+  GLenum m_IndexType{GL_UNSIGNED_INT};
+  std::uintptr_t m_IndexOffset{};  // in bytes into the element buffer
+  GLint m_BaseVertex{};
+  GLsizei m_Instances{1};
+  // optional per-draw vec4 uniform, skipped when the location is -1
+  GLint m_UniformLocation{-1};
+  std::array<float, 4> m_Uniform{};
+};
+
+// Stable LSD radix sort of (key, payload) pairs, 8 bits per pass. Passes in
+// which every key shares the same byte are skipped.
+inline void RadixSort(std::vector<std::pair<std::uint64_t, std::uint32_t>>& items,
+                      std::vector<std::pair<std::uint64_t, std::uint32_t>>& scratch) {
+  constexpr auto kRadixBits = 8U;
+  constexpr auto kBuckets = 1UZ << kRadixBits;
+  scratch.resize(items.size());
+  for (auto Shift = 0U; Shift < 64U; Shift += kRadixBits) {
+    std::array<std::size_t, kBuckets> Counts{};
+    for (auto const& [Key, Payload] : items) {
+      ++Counts[(Key >> Shift) & (kBuckets - 1)];
+    }
+    if (std::ranges::find(Counts, items.size()) != Counts.end()) {
+      continue;
+    }
+    auto Offset = 0UZ;
+    for (auto& Count : Counts) {
+      Offset += std::exchange(Count, Offset);
+    }
+    for (auto const& Item : items) {
+      scratch[Counts[(Item.first >> Shift) & (kBuckets - 1)]++] = Item;
+    }
+    items.swap(scratch);
+  }
+}
+
+// Collects a frame's draws, sorts them by key and submits them through the
+// StateCache so consecutive draws sharing state cost no extra state changes.
+// Storage is reused between frames.
+class RenderQueue {
+  std::vector<DrawCommand> m_Commands;
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> m_Order;
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> m_Scratch;
+
+ public:
+  void Submit(DrawCommand const& command) {
+    m_Order.emplace_back(command.m_Key,
+                         static_cast<std::uint32_t>(m_Commands.size()));
+    m_Commands.push_back(command);
+  }
+  [[nodiscard]] auto Size() const noexcept -> std::size_t {
+    return m_Commands.size();
+  }
+  // Sorted view of the submitted commands, valid until the next Submit.
+  auto Sort() -> std::span<std::pair<std::uint64_t, std::uint32_t> const> {
+    RadixSort(m_Order, m_Scratch);
+    return m_Order;
+  }
+  void Clear() {
+    m_Commands.clear();
+    m_Order.clear();
+  }
+  // Sorts, issues every draw and clears the queue.
+  void Flush() {
+    auto& State = StateCache::Instance();
+    auto& Stats = FrameStats::Instance();
+    for (auto const& [Key, Index] : Sort()) {
+      auto const& Command = m_Commands[Index];
+      State.SetBlend(sort_key::IsTranslucent(Key));
+      State.UseProgram(Command.m_Program);
+      State.BindVertexArray(Command.m_VertexArray);
+      if (Command.m_UniformLocation >= 0) {
+        auto const& [X, Y, Z, W] = Command.m_Uniform;
+        State.Uniform4f(Command.m_UniformLocation, X, Y, Z, W);
+      }
+      // NOLINTNEXTLINE
+      auto* const Indices = reinterpret_cast<void*>(Command.m_IndexOffset);
+      Stats.CountDraw(TriangleCount(
+          Command.m_Mode, static_cast<std::uint64_t>(Command.m_Count),
+          static_cast<std::uint64_t>(Command.m_Instances)));
+      if (Command.m_Instances == 1) {
+        glDrawElementsBaseVertex(Command.m_Mode, Command.m_Count,
+                                 Command.m_IndexType, Indices,
+                                 Command.m_BaseVertex);
+      } else {
+        glDrawElementsInstancedBaseVertex(
+            Command.m_Mode, Command.m_Count, Command.m_IndexType, Indices,
+            Command.m_Instances, Command.m_BaseVertex);
+      }
+    }
+    Clear();
+  }
+};
+
+}  // namespace gl
+#endif
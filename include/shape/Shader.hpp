@@ -58,7 +58,8 @@ inline auto CompileShaderNoThrow(std::string_view source, unsigned int type)
 
 // NOLINTNEXTLINE
 inline auto CreateShader(std::string_view vertexShader,
-                         std::string_view fragmentShader)
+                         std::string_view fragmentShader,
+                         bool retrievableBinary = false)
     -> gl::errors::Expected<unsigned int> {
   auto Prog = glCreateProgram();
   auto VertexShader = CompileShaderNoThrow(vertexShader, GL_VERTEX_SHADER);
@@ -80,49 +81,63 @@ inline auto CreateShader(std::string_view vertexShader,
   }
   glAttachShader(Prog, *VertexShader);
   glAttachShader(Prog, *FragmentShader);
+  if (retrievableBinary) {
+    glProgramParameteri(Prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(Prog);
   glValidateProgram(Prog);
 
   glDeleteShader(*VertexShader);
   glDeleteShader(*FragmentShader);
 
-  return Prog;
-}
-inline auto CreateShaderFromFile(
-    std::filesystem::path const &vertexShaderPath,
-    std::filesystem::path const &fragmentShaderPath)
-    -> gl::errors::Expected<unsigned int> {
-  if (!std::filesystem::is_regular_file(vertexShaderPath)) {
-    std::unexpected(gl::errors::State(
-        std::format("No such vertex shader path found path: {}",
-                    vertexShaderPath.string()),
-        gl::errors::ErrorLevel::kError));
-  }
-  if (!std::filesystem::is_regular_file(fragmentShaderPath)) {
-    std::unexpected(gl::errors::State(
-        std::format("No such fragment shader path found path: {}",
-                    vertexShaderPath.string()),
+  int Linked = 0;
+  glGetProgramiv(Prog, GL_LINK_STATUS, &Linked);
+  if (Linked == GL_FALSE) {
+    int Length = 0;
+    glGetProgramiv(Prog, GL_INFO_LOG_LENGTH, &Length);
+    std::string Message(static_cast<std::size_t>(Length), '\0');
+    glGetProgramInfoLog(Prog, Length, &Length, Message.data());
+    glDeleteProgram(Prog);
+    return std::unexpected(gl::errors::State(
+        std::format("Program failed to link, Message: {}", Message),
         gl::errors::ErrorLevel::kError));
   }
-  std::stringstream VertexShaderStream;
-  try {
-    VertexShaderStream << std::ifstream(vertexShaderPath).rdbuf();
-  } catch (std::exception const &Err) {
+
+  return Prog;
+}
+inline auto ReadShaderFile(std::filesystem::path const &shaderPath,
+                           std::string_view stage)
+    -> gl::errors::Expected<std::string> {
+  if (!std::filesystem::is_regular_file(shaderPath)) {
     return std::unexpected(gl::errors::State(
-        std::format("Error opening vertex shader file see error: {}",
-                    Err.what()),
+        std::format("No such {} shader path found path: {}", stage,
+                    shaderPath.string()),
         gl::errors::ErrorLevel::kError));
   }
-  std::stringstream FragmentShaderStream;
+  std::stringstream ShaderStream;
   try {
-    FragmentShaderStream << std::ifstream(fragmentShaderPath).rdbuf();
+    ShaderStream << std::ifstream(shaderPath).rdbuf();
   } catch (std::exception const &Err) {
     return std::unexpected(gl::errors::State(
-        std::format("Error opening fragment shader file see error: {}",
+        std::format("Error opening {} shader file see error: {}", stage,
                     Err.what()),
         gl::errors::ErrorLevel::kError));
   }
-  return CreateShader(VertexShaderStream.str(), FragmentShaderStream.str());
+  return ShaderStream.str();
+}
+inline auto CreateShaderFromFile(
+    std::filesystem::path const &vertexShaderPath,
+    std::filesystem::path const &fragmentShaderPath)
+    -> gl::errors::Expected<unsigned int> {
+  auto VertexShaderSource = ReadShaderFile(vertexShaderPath, "vertex");
+  if (!VertexShaderSource) {
+    return std::unexpected(VertexShaderSource.error());
+  }
+  auto FragmentShaderSource = ReadShaderFile(fragmentShaderPath, "fragment");
+  if (!FragmentShaderSource) {
+    return std::unexpected(FragmentShaderSource.error());
+  }
+  return CreateShader(*VertexShaderSource, *FragmentShaderSource);
 }
 inline auto CompileShader(std::string_view source, unsigned int type)
     -> unsigned int {
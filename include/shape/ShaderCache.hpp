@@ -0,0 +1,221 @@
+#ifndef SHAPE_SHADERCACHE_HPP
+#define SHAPE_SHADERCACHE_HPP
+#include <glad/glad.h>  //
+#include <spdlog/spdlog.h>
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <shape/Errors.hpp>
+#include <shape/Hash.hpp>
+#include <shape/ProgramBinaryCache.hpp>
+#include <shape/Shader.hpp>
+#include <shape/StateCache.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+namespace gl {
+
+// Inserts one "#define <define>" line per entry right after the #version
+// directive (or at the top when there is none).
+inline auto InjectDefines(std::string_view source,
+                          std::span<std::string_view const> defines)
+    -> std::string {
+  if (defines.empty()) {
+    return std::string{source};
+  }
+  auto InsertAt = 0UZ;
+  if (auto Version = source.find("#version"); Version != std::string_view::npos) {
+    auto LineEnd = source.find('\n', Version);
+    InsertAt = (LineEnd == std::string_view::npos) ? source.size() : LineEnd + 1;
+  }
+  std::string Result{source.substr(0, InsertAt)};
+  if (!Result.empty() && Result.back() != '\n') {
+    Result += '\n';
+  }
+  for (auto Define : defines) {
+    Result += "#define ";
+    Result += Define;
+    Result += '\n';
+  }
+  Result += source.substr(InsertAt);
+  return Result;
+}
+
+// Owns one linked program; shared between all users of the same sources.
+class Program {
+  GLuint m_id;
+  std::uint64_t m_Key;
+
+ public:
+  Program(GLuint id, std::uint64_t key) : m_id{id}, m_Key{key} {}
+  Program(Program const &) = delete;
+  auto operator=(Program const &) -> Program & = delete;
+  Program(Program &&) = delete;
+  auto operator=(Program &&) -> Program & = delete;
+  ~Program() {
+    if (m_id != 0) {
+      StateCache::Instance().ForgetProgram(m_id);
+      glDeleteProgram(m_id);
+    }
+  }
+  [[nodiscard]] auto Get() const noexcept -> GLuint { return m_id; }
+  [[nodiscard]] auto Key() const noexcept -> std::uint64_t { return m_Key; }
+};
+using ProgramHandle = std::shared_ptr<Program const>;
+
+// Process-wide cache of linked programs keyed by a hash of the stage sources
+// and defines. Programs stay alive while any handle refers to them and are
+// recompiled on the next request once the last handle is gone. With a binary
+// cache attached, misses try the on-disk program binary before compiling.
+// Must only be used from the thread that owns the GL context.
+class ShaderCache {
+ public:
+  struct Stats {
+    std::size_t m_Hits{};
+    std::size_t m_Misses{};
+  };
+
+ private:
+  struct Entry {
+    std::weak_ptr<Program const> m_Program;
+    // what the key hashes, compared on every hit
+    std::string m_Sources;
+  };
+
+  std::unordered_map<std::uint64_t, Entry> m_Programs;
+  std::optional<ProgramBinaryCache> m_BinaryCache;
+  Stats m_Stats;
+
+  auto Link(std::uint64_t cacheKey, std::string_view vertexShader,
+            std::string_view fragmentShader,
+            std::span<std::string_view const> defines)
+      -> gl::errors::Expected<GLuint> {
+    if (m_BinaryCache) {
+      if (auto Loaded = m_BinaryCache->Load(cacheKey)) {
+        return *Loaded;
+      }
+    }
+    auto Linked = CreateShader(InjectDefines(vertexShader, defines),
+                               InjectDefines(fragmentShader, defines),
+                               m_BinaryCache.has_value());
+    if (Linked && m_BinaryCache) {
+      m_BinaryCache->Store(cacheKey, *Linked);
+    }
+    return Linked;
+  }
+
+  ShaderCache() = default;
+
+ public:
+  ShaderCache(ShaderCache const &) = delete;
+  auto operator=(ShaderCache const &) -> ShaderCache & = delete;
+  ShaderCache(ShaderCache &&) = delete;
+  auto operator=(ShaderCache &&) -> ShaderCache & = delete;
+  ~ShaderCache() = default;
+
+  static auto Instance() -> ShaderCache & {
+    static ShaderCache Cache;
+    return Cache;
+  }
+
+  // The stage sources and defines as one string, the bytes Key hashes.
+  static auto Sources(std::string_view vertexShader,
+                      std::string_view fragmentShader,
+                      std::span<std::string_view const> defines = {})
+      -> std::string {
+    // the separator keeps ("ab", "c") and ("a", "bc") apart
+    constexpr auto kSeparator = std::string_view{"\0", 1};
+    std::string Result{vertexShader};
+    Result += kSeparator;
+    Result += fragmentShader;
+    for (auto Define : defines) {
+      Result += kSeparator;
+      Result += Define;
+    }
+    return Result;
+  }
+  static auto Key(std::string_view vertexShader,
+                  std::string_view fragmentShader,
+                  std::span<std::string_view const> defines = {})
+      -> std::uint64_t {
+    return HashBytes(Sources(vertexShader, fragmentShader, defines));
+  }
+
+  auto Get(std::string_view vertexShader, std::string_view fragmentShader,
+           std::span<std::string_view const> defines = {})
+      -> gl::errors::Expected<ProgramHandle> {
+    auto Identity = Sources(vertexShader, fragmentShader, defines);
+    auto const CacheKey = HashBytes(Identity);
+    if (auto Found = m_Programs.find(CacheKey); Found != m_Programs.end()) {
+      if (Found->second.m_Sources != Identity) {
+        // a hash collision; the newer sources take the entry over
+        spdlog::warn("Shader cache key {:016x} collides, relinking", CacheKey);
+      } else if (auto Shared = Found->second.m_Program.lock()) {
+        ++m_Stats.m_Hits;
+        return Shared;
+      }
+    }
+    ++m_Stats.m_Misses;
+    auto Linked = Link(CacheKey, vertexShader, fragmentShader, defines);
+    if (!Linked) {
+      return std::unexpected(Linked.error());
+    }
+    auto Shared = std::make_shared<Program const>(*Linked, CacheKey);
+    m_Programs.insert_or_assign(
+        CacheKey, Entry{.m_Program = Shared, .m_Sources = std::move(Identity)});
+    return Shared;
+  }
+  auto Get(std::string_view vertexShader, std::string_view fragmentShader,
+           std::initializer_list<std::string_view> defines)
+      -> gl::errors::Expected<ProgramHandle> {
+    return Get(vertexShader, fragmentShader,
+               std::span<std::string_view const>(defines.begin(),
+                                                 defines.size()));
+  }
+
+  auto GetFromFiles(std::filesystem::path const &vertexShaderPath,
+                    std::filesystem::path const &fragmentShaderPath,
+                    std::span<std::string_view const> defines = {})
+      -> gl::errors::Expected<ProgramHandle> {
+    auto VertexShaderSource = ReadShaderFile(vertexShaderPath, "vertex");
+    if (!VertexShaderSource) {
+      return std::unexpected(VertexShaderSource.error());
+    }
+    auto FragmentShaderSource = ReadShaderFile(fragmentShaderPath, "fragment");
+    if (!FragmentShaderSource) {
+      return std::unexpected(FragmentShaderSource.error());
+    }
+    return Get(*VertexShaderSource, *FragmentShaderSource, defines);
+  }
+
+  // Persists linked programs under directory; std::nullopt detaches.
+  void SetBinaryCache(std::optional<std::filesystem::path> directory) {
+    m_BinaryCache.reset();
+    if (directory) {
+      m_BinaryCache.emplace(*std::move(directory));
+    }
+  }
+  [[nodiscard]] auto GetBinaryCache() const noexcept
+      -> std::optional<ProgramBinaryCache> const & {
+    return m_BinaryCache;
+  }
+
+  // Drops bookkeeping for programs whose last handle is gone.
+  void Purge() {
+    std::erase_if(m_Programs, [](auto const &Cached) -> bool {
+      return Cached.second.m_Program.expired();
+    });
+  }
+  [[nodiscard]] auto GetStats() const noexcept -> Stats { return m_Stats; }
+  void ResetStats() noexcept { m_Stats = {}; }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,128 @@
+#ifndef SHAPE_SIMD_HPP
+#define SHAPE_SIMD_HPP
+
+#include <cstring>
+
+// Four float lanes for the gl::Vector fast paths. x86 uses SSE (plus SSE4.1
+// and FMA when the compiler targets them); elsewhere std::experimental::simd
+// is used when available. Without either, SHAPE_SIMD stays undefined and
+// Vector.hpp keeps its plain loops.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define SHAPE_SIMD 1
+#define SHAPE_SIMD_SSE 1
+#elif __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define SHAPE_SIMD 1
+#define SHAPE_SIMD_STDX 1
+#endif
+
+#ifdef SHAPE_SIMD
+namespace gl::simd {
+
+#ifdef SHAPE_SIMD_SSE
+using Float4 = __m128;
+
+inline auto Load(float const* values) -> Float4 { return _mm_loadu_ps(values); }
+// w is zeroed, so dot products and lengths of 3-vectors stay exact.
+inline auto Load3(float const* values) -> Float4 {
+  return _mm_setr_ps(values[0], values[1], values[2], 0.0F);
+}
+inline void Store(float* out, Float4 value) { _mm_storeu_ps(out, value); }
+inline void Store3(float* out, Float4 value) {
+  alignas(16) float Lanes[4];
+  _mm_store_ps(Lanes, value);
+  std::memcpy(out, Lanes, 3 * sizeof(float));
+}
+inline auto Splat(float value) -> Float4 { return _mm_set1_ps(value); }
+inline auto Add(Float4 lhs, Float4 rhs) -> Float4 { return _mm_add_ps(lhs, rhs); }
+inline auto Sub(Float4 lhs, Float4 rhs) -> Float4 { return _mm_sub_ps(lhs, rhs); }
+inline auto Mul(Float4 lhs, Float4 rhs) -> Float4 { return _mm_mul_ps(lhs, rhs); }
+inline auto Min(Float4 lhs, Float4 rhs) -> Float4 { return _mm_min_ps(lhs, rhs); }
+inline auto Max(Float4 lhs, Float4 rhs) -> Float4 { return _mm_max_ps(lhs, rhs); }
+// lhs * rhs + addend, fused where the target has FMA
+inline auto MulAdd(Float4 lhs, Float4 rhs, Float4 addend) -> Float4 {
+#ifdef __FMA__
+  return _mm_fmadd_ps(lhs, rhs, addend);
+#else
+  return _mm_add_ps(_mm_mul_ps(lhs, rhs), addend);
+#endif
+}
+inline auto Dot(Float4 lhs, Float4 rhs) -> float {
+#ifdef __SSE4_1__
+  return _mm_cvtss_f32(_mm_dp_ps(lhs, rhs, 0xF1));
+#else
+  auto Product = _mm_mul_ps(lhs, rhs);
+  auto Swapped = _mm_shuffle_ps(Product, Product, _MM_SHUFFLE(2, 3, 0, 1));
+  auto Sums = _mm_add_ps(Product, Swapped);
+  Swapped = _mm_movehl_ps(Swapped, Sums);
+  return _mm_cvtss_f32(_mm_add_ss(Sums, Swapped));
+#endif
+}
+// Cross product of the xyz lanes; w of the result is 0 for zero-w inputs.
+inline auto Cross(Float4 lhs, Float4 rhs) -> Float4 {
+  auto const LhsYzx = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 0, 2, 1));
+  auto const RhsYzx = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 2, 1));
+  auto const Zxy = _mm_sub_ps(_mm_mul_ps(lhs, RhsYzx), _mm_mul_ps(LhsYzx, rhs));
+  return _mm_shuffle_ps(Zxy, Zxy, _MM_SHUFFLE(3, 0, 2, 1));
+}
+#else
+namespace stdx = std::experimental;
+using Float4 = stdx::fixed_size_simd<float, 4>;
+
+inline auto Load(float const* values) -> Float4 {
+  return Float4(values, stdx::element_aligned);
+}
+inline auto Load3(float const* values) -> Float4 {
+  return Float4([values](auto Lane) -> float {
+    return Lane < 3 ? values[Lane] : 0.0F;
+  });
+}
+inline void Store(float* out, Float4 const& value) {
+  value.copy_to(out, stdx::element_aligned);
+}
+inline void Store3(float* out, Float4 const& value) {
+  float Lanes[4];
+  value.copy_to(Lanes, stdx::element_aligned);
+  std::memcpy(out, Lanes, 3 * sizeof(float));
+}
+inline auto Splat(float value) -> Float4 { return Float4(value); }
+inline auto Add(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return lhs + rhs;
+}
+inline auto Sub(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return lhs - rhs;
+}
+inline auto Mul(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return lhs * rhs;
+}
+inline auto Min(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return stdx::min(lhs, rhs);
+}
+inline auto Max(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return stdx::max(lhs, rhs);
+}
+inline auto MulAdd(Float4 const& lhs, Float4 const& rhs, Float4 const& addend)
+    -> Float4 {
+  return stdx::fma(lhs, rhs, addend);
+}
+inline auto Dot(Float4 const& lhs, Float4 const& rhs) -> float {
+  return stdx::reduce(lhs * rhs);
+}
+inline auto Cross(Float4 const& lhs, Float4 const& rhs) -> Float4 {
+  return Float4([&](auto Lane) -> float {
+    if constexpr (Lane == 3) {
+      return 0.0F;
+    } else {
+      constexpr auto kNext = (Lane + 1) % 3;
+      constexpr auto kLast = (Lane + 2) % 3;
+      return (lhs[kNext] * rhs[kLast]) - (lhs[kLast] * rhs[kNext]);
+    }
+  });
+}
+#endif
+
+}  // namespace gl::simd
+#endif
+#endif
@@ -0,0 +1,187 @@
+#ifndef SHAPE_STATECACHE_HPP
+#define SHAPE_STATECACHE_HPP
+#include <glad/glad.h>  //
+//
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shape/FrameStats.hpp>
+#include <unordered_map>
+#include <utility>
+namespace gl {
+
+// Shadows the GL state that the shape headers change per draw and drops
+// calls that would not change it. Everything that binds, uses or uploads
+// through the wrappers goes through Instance(); code issuing raw GL calls for
+// the same state must call Invalidate() afterwards. Only for use on the
+// thread owning the context.
+class StateCache {
+ public:
+  struct Counter {
+    std::size_t m_Issued{};
+    std::size_t m_Elided{};
+  };
+  struct Stats {
+    Counter m_VertexArray;
+    Counter m_Program;
+    Counter m_Buffer;
+    Counter m_Uniform;
+    Counter m_Blend;
+    [[nodiscard]] auto Issued() const noexcept -> std::size_t {
+      return m_VertexArray.m_Issued + m_Program.m_Issued + m_Buffer.m_Issued +
+             m_Uniform.m_Issued + m_Blend.m_Issued;
+    }
+    [[nodiscard]] auto Elided() const noexcept -> std::size_t {
+      return m_VertexArray.m_Elided + m_Program.m_Elided + m_Buffer.m_Elided +
+             m_Uniform.m_Elided + m_Blend.m_Elided;
+    }
+  };
+
+ private:
+  std::optional<GLuint> m_VertexArray;
+  std::optional<GLuint> m_Program;
+  std::unordered_map<GLenum, GLuint> m_Buffers;
+  std::optional<bool> m_BlendEnabled;
+  std::optional<std::pair<GLenum, GLenum>> m_BlendFunc;
+  // (program << 32 | location) -> last uploaded value
+  std::unordered_map<std::uint64_t, std::array<float, 4>> m_Uniforms;
+  Stats m_Stats;
+
+  // Returns true when the call has to be issued and records the new value.
+  template <typename T>
+  static auto Update(std::optional<T>& current, T const& value,
+                     Counter& counter) -> bool {
+    if (current == value) {
+      ++counter.m_Elided;
+      return false;
+    }
+    current = value;
+    ++counter.m_Issued;
+    return true;
+  }
+
+  StateCache() = default;
+
+ public:
+  StateCache(StateCache const&) = delete;
+  auto operator=(StateCache const&) -> StateCache& = delete;
+  StateCache(StateCache&&) = delete;
+  auto operator=(StateCache&&) -> StateCache& = delete;
+  ~StateCache() = default;
+
+  static auto Instance() -> StateCache& {
+    static StateCache Cache;
+    return Cache;
+  }
+
+  void BindVertexArray(GLuint vertexArray) {
+    if (Update(m_VertexArray, vertexArray, m_Stats.m_VertexArray)) {
+      FrameStats::Instance().CountVertexArrayBind();
+      glBindVertexArray(vertexArray);
+    }
+  }
+  void UseProgram(GLuint program) {
+    if (Update(m_Program, program, m_Stats.m_Program)) {
+      FrameStats::Instance().CountProgramSwitch();
+      glUseProgram(program);
+    }
+  }
+  // The element array binding is part of the bound vertex array, and DSA
+  // calls change it without a bind, so that target is never elided.
+  void BindBuffer(GLenum target, GLuint buffer) {
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+      ++m_Stats.m_Buffer.m_Issued;
+      FrameStats::Instance().CountBufferBind();
+      glBindBuffer(target, buffer);
+      return;
+    }
+    auto [Slot, Inserted] = m_Buffers.try_emplace(target, buffer);
+    if (!Inserted && Slot->second == buffer) {
+      ++m_Stats.m_Buffer.m_Elided;
+      return;
+    }
+    Slot->second = buffer;
+    ++m_Stats.m_Buffer.m_Issued;
+    FrameStats::Instance().CountBufferBind();
+    glBindBuffer(target, buffer);
+  }
+  void SetBlend(bool enabled) {
+    if (Update(m_BlendEnabled, enabled, m_Stats.m_Blend)) {
+      if (enabled) {
+        glEnable(GL_BLEND);
+      } else {
+        glDisable(GL_BLEND);
+      }
+    }
+  }
+  void BlendFunc(GLenum source, GLenum destination) {
+    if (Update(m_BlendFunc, std::pair{source, destination}, m_Stats.m_Blend)) {
+      glBlendFunc(source, destination);
+    }
+  }
+  // Sets a uniform of the program currently in use.
+  void Uniform4f(GLint location, float x, float y, float z, float w) {
+    if (location < 0) {
+      return;
+    }
+    if (!m_Program) {
+      ++m_Stats.m_Uniform.m_Issued;
+      FrameStats::Instance().CountUniformUpdate();
+      glUniform4f(location, x, y, z, w);
+      return;
+    }
+    auto const Key = (static_cast<std::uint64_t>(*m_Program) << 32U) |
+                     static_cast<std::uint32_t>(location);
+    auto const Value = std::array{x, y, z, w};
+    auto [Slot, Inserted] = m_Uniforms.try_emplace(Key, Value);
+    if (!Inserted && Slot->second == Value) {
+      ++m_Stats.m_Uniform.m_Elided;
+      return;
+    }
+    Slot->second = Value;
+    ++m_Stats.m_Uniform.m_Issued;
+    FrameStats::Instance().CountUniformUpdate();
+    glUniform4f(location, x, y, z, w);
+  }
+
+  // Object names get recycled, so deleting an object must drop what is
+  // remembered about it; GL itself resets bindings of deleted objects to 0.
+  void ForgetVertexArray(GLuint vertexArray) {
+    if (m_VertexArray == vertexArray) {
+      m_VertexArray = 0;
+    }
+  }
+  void ForgetBuffer(GLuint buffer) {
+    for (auto& [Target, Bound] : m_Buffers) {
+      if (Bound == buffer) {
+        Bound = 0;
+      }
+    }
+  }
+  void ForgetProgram(GLuint program) {
+    std::erase_if(m_Uniforms, [program](auto const& Entry) -> bool {
+      return (Entry.first >> 32U) == program;
+    });
+    if (m_Program == program) {
+      // a deleted program stays in use until another one is installed
+      m_Program.reset();
+    }
+  }
+  // Forget everything, e.g. after raw GL calls or a context switch.
+  void Invalidate() {
+    m_VertexArray.reset();
+    m_Program.reset();
+    m_Buffers.clear();
+    m_BlendEnabled.reset();
+    m_BlendFunc.reset();
+    m_Uniforms.clear();
+  }
+
+  [[nodiscard]] auto GetStats() const noexcept -> Stats { return m_Stats; }
+  void ResetStats() noexcept { m_Stats = {}; }
+};
+
+}  // namespace gl
+#endif
@@ -0,0 +1,186 @@
+#ifndef SHAPE_STREAMINGRINGBUFFER_HPP
+#define SHAPE_STREAMINGRINGBUFFER_HPP
+#include <glad/glad.h>  //
+//
+
+#include <cstddef>
+#include <optional>
+#include <shape/Buffer.hpp>
+#include <shape/Errors.hpp>
+#include <shape/StateCache.hpp>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// A persistently and coherently mapped buffer split into one region per
+// frame in flight. Each frame writes straight into its region; a fence placed
+// at EndFrame guards the region until the GPU is done reading it, so uploads
+// never orphan storage or trigger an implicit sync.
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class StreamingRingBuffer {
+ public:
+  struct Allocation {
+    std::span<T> m_Data;
+    // index of m_Data[0] in the whole buffer, usable as a base vertex or
+    // multiplied by sizeof(T) as a byte offset
+    std::size_t m_FirstElement{};
+  };
+  struct Stats {
+    std::size_t m_Frames{};
+    std::size_t m_Stalls{};  // fences that were not yet signalled on reuse
+    std::size_t m_Overflows{};
+    std::size_t m_WaitFailures{};
+  };
+
+ private:
+  static constexpr GLbitfield kMapFlags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  static constexpr GLuint64 kWaitTimeoutNs = 1'000'000;
+
+  GLuint m_id{};
+  std::size_t m_RegionElements{};
+  std::size_t m_RegionCount{};
+  T* m_Mapped = nullptr;
+  std::vector<GLsync> m_Fences;
+  std::size_t m_Region{};
+  std::size_t m_Cursor{};
+  Stats m_Stats;
+
+  // False when the fence could not be waited on; the region may still be
+  // read by the GPU then.
+  auto WaitForRegion(std::size_t region) -> bool {
+    auto& Fence = m_Fences[region];
+    if (Fence == nullptr) {
+      return true;
+    }
+    auto Status = glClientWaitSync(Fence, 0, 0);
+    if (Status != GL_ALREADY_SIGNALED && Status != GL_CONDITION_SATISFIED) {
+      ++m_Stats.m_Stalls;
+      while (Status == GL_TIMEOUT_EXPIRED) {
+        Status = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  kWaitTimeoutNs);
+      }
+    }
+    glDeleteSync(Fence);
+    Fence = nullptr;
+    return Status != GL_WAIT_FAILED;
+  }
+  void Release() noexcept {
+    for (auto& Fence : m_Fences) {
+      if (Fence != nullptr) {
+        glDeleteSync(Fence);
+      }
+    }
+    m_Fences.clear();
+    if (m_id != 0) {
+      StateCache::Instance().ForgetBuffer(m_id);
+      glUnmapNamedBuffer(m_id);
+      glDeleteBuffers(1, &m_id);
+      m_id = 0;
+    }
+    m_Mapped = nullptr;
+  }
+
+ public:
+  // A mapping the driver refuses is reported by every BeginFrame.
+  explicit StreamingRingBuffer(std::size_t elementsPerRegion,
+                               std::size_t regions = 3)
+      : m_RegionElements(elementsPerRegion),
+        m_RegionCount(regions),
+        m_Fences(regions, nullptr) {
+    if (elementsPerRegion == 0 || regions == 0) {
+      throw std::invalid_argument(
+          "StreamingRingBuffer: regions and their sizes must not be 0");
+    }
+    auto const Bytes =
+        static_cast<GLsizeiptr>(m_RegionElements * m_RegionCount * sizeof(T));
+    glCreateBuffers(1, &m_id);
+    glNamedBufferStorage(m_id, Bytes, nullptr, kMapFlags);
+    m_Mapped =
+        static_cast<T*>(glMapNamedBufferRange(m_id, 0, Bytes, kMapFlags));
+  }
+  StreamingRingBuffer(StreamingRingBuffer const&) = delete;
+  auto operator=(StreamingRingBuffer const&) -> StreamingRingBuffer& = delete;
+  StreamingRingBuffer(StreamingRingBuffer&& other) noexcept
+      : m_id(std::exchange(other.m_id, 0)),
+        m_RegionElements(other.m_RegionElements),
+        m_RegionCount(other.m_RegionCount),
+        m_Mapped(std::exchange(other.m_Mapped, nullptr)),
+        m_Fences(std::move(other.m_Fences)),
+        m_Region(other.m_Region),
+        m_Cursor(other.m_Cursor),
+        m_Stats(other.m_Stats) {}
+  auto operator=(StreamingRingBuffer&& other) noexcept -> StreamingRingBuffer& {
+    if (this != &other) {
+      Release();
+      m_id = std::exchange(other.m_id, 0);
+      m_RegionElements = other.m_RegionElements;
+      m_RegionCount = other.m_RegionCount;
+      m_Mapped = std::exchange(other.m_Mapped, nullptr);
+      m_Fences = std::move(other.m_Fences);
+      m_Region = other.m_Region;
+      m_Cursor = other.m_Cursor;
+      m_Stats = other.m_Stats;
+    }
+    return *this;
+  }
+  ~StreamingRingBuffer() { Release(); }
+
+  // Moves to the next region, blocking only if the GPU still reads it. When
+  // the buffer is not mapped or the region's fence cannot be waited on,
+  // nothing is allocated this frame.
+  auto BeginFrame() -> gl::errors::Expected<void> {
+    if (m_Mapped == nullptr) {
+      return std::unexpected(gl::errors::State{
+          "StreamingRingBuffer: the buffer is not mapped",
+          gl::errors::ErrorLevel::kError});
+    }
+    m_Region = (m_Region + 1) % m_RegionCount;
+    m_Cursor = 0;
+    if (!WaitForRegion(m_Region)) {
+      ++m_Stats.m_WaitFailures;
+      m_Cursor = m_RegionElements;
+      return std::unexpected(gl::errors::State{
+          "StreamingRingBuffer: waiting for the region's fence failed",
+          gl::errors::ErrorLevel::kError});
+    }
+    return {};
+  }
+  // Hands out count elements of the current region, or std::nullopt once the
+  // region is exhausted for this frame.
+  auto Allocate(std::size_t count) -> std::optional<Allocation> {
+    if (m_Mapped == nullptr || m_Cursor + count > m_RegionElements) {
+      ++m_Stats.m_Overflows;
+      return std::nullopt;
+    }
+    auto const First = (m_Region * m_RegionElements) + m_Cursor;
+    m_Cursor += count;
+    return Allocation{.m_Data = std::span<T>(m_Mapped + First, count),
+                      .m_FirstElement = First};
+  }
+  // Call after the last draw reading this frame's region was issued.
+  void EndFrame() {
+    auto& Fence = m_Fences[m_Region];
+    if (Fence != nullptr) {
+      glDeleteSync(Fence);
+    }
+    Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_Stats.m_Frames;
+  }
+
+  auto Bind(BufferType type) const -> void {
+    StateCache::Instance().BindBuffer(static_cast<GLenum>(type), m_id);
+  }
+  [[nodiscard]] auto Get() const noexcept -> GLuint { return m_id; }
+  [[nodiscard]] auto RegionElements() const noexcept -> std::size_t {
+    return m_RegionElements;
+  }
+  [[nodiscard]] auto GetStats() const noexcept -> Stats { return m_Stats; }
+};
+
+}  // namespace gl
+#endif
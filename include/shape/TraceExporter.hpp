@@ -0,0 +1,279 @@
+#ifndef SHAPE_TRACEEXPORTER_HPP
+#define SHAPE_TRACEEXPORTER_HPP
+#include <spdlog/spdlog.h>
+//
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <shape/Errors.hpp>
+#include <shape/Profiler.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// A named value sampled once per frame, written as a trace counter track.
+struct TraceCounter {
+  std::string_view m_Name;
+  double m_Value{};
+};
+
+// Streams profiled frames as Chrome Trace Event JSON, readable by
+// chrome://tracing and ui.perfetto.dev. Events are formatted into fixed-size
+// chunks on the frame thread and written by a background thread. When the
+// disk falls behind and the pending chunk limit is reached, further chunks
+// are dropped rather than stalling the frame. A chunk is only handed off
+// between whole events, and the opening and closing chunks are always kept,
+// so a dropped chunk loses events but never leaves the file invalid. Capture
+// is started and stopped from the frame thread only; RequestToggle may be
+// called from anywhere, including signal handlers.
+class TraceExporter {
+ public:
+  static constexpr auto kChunkBytes = 64UZ * 1024;
+  static constexpr auto kMaxPendingChunks = 8UZ;
+  static constexpr auto kGpuTrack = 1'000'000U;
+
+ private:
+  std::filesystem::path m_Path;
+  std::size_t m_MaxPendingChunks;
+  std::ofstream m_File;
+  std::string m_Chunk;
+  std::mutex m_Mutex;
+  std::condition_variable m_Wake;
+  std::deque<std::string> m_Pending;
+  std::vector<std::string> m_Spare;
+  std::thread m_Writer;
+  bool m_Closing{false};
+  std::atomic<bool> m_ToggleRequested{false};
+  std::vector<std::uint32_t> m_NamedThreads;
+  std::int64_t m_Origin{};
+  std::uint64_t m_Frames{};
+  std::uint64_t m_FrameLimit{};
+  std::uint64_t m_Captures{};
+  std::uint64_t m_DroppedChunks{};
+
+  void WriterLoop() {
+    std::unique_lock Lock{m_Mutex};
+    while (true) {
+      m_Wake.wait(Lock, [this] { return m_Closing || !m_Pending.empty(); });
+      if (m_Pending.empty()) {
+        return;
+      }
+      auto Chunk = std::move(m_Pending.front());
+      m_Pending.pop_front();
+      Lock.unlock();
+      m_File.write(Chunk.data(), static_cast<std::streamsize>(Chunk.size()));
+      Chunk.clear();
+      Lock.lock();
+      if (m_Spare.size() < m_MaxPendingChunks) {
+        m_Spare.push_back(std::move(Chunk));
+      }
+    }
+  }
+  // The opening and closing chunks are always queued, whatever the backlog.
+  void Submit(bool keep = false) {
+    {
+      std::scoped_lock const Lock{m_Mutex};
+      if (!keep && m_Pending.size() >= m_MaxPendingChunks) {
+        ++m_DroppedChunks;
+        m_Chunk.clear();
+        // the chunk may have held thread names; write them again
+        m_NamedThreads.clear();
+        return;
+      }
+      m_Pending.push_back(std::move(m_Chunk));
+      m_Chunk.clear();
+      if (!m_Spare.empty()) {
+        m_Chunk = std::move(m_Spare.back());
+        m_Spare.pop_back();
+      }
+    }
+    m_Chunk.reserve(kChunkBytes);
+    m_Wake.notify_one();
+  }
+  template <typename... Args>
+  void Append(std::format_string<Args...> format, Args&&... args) {
+    std::format_to(std::back_inserter(m_Chunk), format,
+                   std::forward<Args>(args)...);
+  }
+  // Called after every whole event, so a chunk never ends mid-event.
+  void EndEvent() {
+    if (m_Chunk.size() >= kChunkBytes) {
+      Submit();
+    }
+  }
+  // Names are literals in practice; escape anyway so the JSON stays valid.
+  void AppendName(std::string_view name) {
+    for (auto Character : name) {
+      if (Character == '"' || Character == '\\') {
+        m_Chunk.push_back('\\');
+        m_Chunk.push_back(Character);
+      } else if (static_cast<unsigned char>(Character) < 0x20) {
+        std::format_to(std::back_inserter(m_Chunk), "\\u{:04x}",
+                       static_cast<unsigned>(Character));
+      } else {
+        m_Chunk.push_back(Character);
+      }
+    }
+  }
+  [[nodiscard]] auto Microseconds(std::int64_t nanoseconds) const -> double {
+    return static_cast<double>(nanoseconds - m_Origin) / 1000.0;
+  }
+  void NameThread(std::uint32_t thread) {
+    if (std::ranges::find(m_NamedThreads, thread) != m_NamedThreads.end()) {
+      return;
+    }
+    m_NamedThreads.push_back(thread);
+    Append(
+        ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"",
+        thread);
+    if (thread == kGpuTrack) {
+      Append("GPU");
+    } else {
+      Append("Thread {}", thread);
+    }
+    Append("\"}}}}");
+    EndEvent();
+  }
+  [[nodiscard]] auto CapturePath() const -> std::filesystem::path {
+    if (m_Captures == 0) {
+      return m_Path;
+    }
+    auto Numbered = m_Path;
+    Numbered.replace_filename(std::format("{}-{}{}", m_Path.stem().string(),
+                                          m_Captures,
+                                          m_Path.extension().string()));
+    return Numbered;
+  }
+
+ public:
+  // Captures go to path; the second and later ones get -1, -2... appended.
+  // At most maxPendingChunks wait for the disk before chunks are dropped.
+  explicit TraceExporter(std::filesystem::path path,
+                         std::size_t maxPendingChunks = kMaxPendingChunks)
+      : m_Path{std::move(path)}, m_MaxPendingChunks{maxPendingChunks} {}
+  TraceExporter(TraceExporter const&) = delete;
+  auto operator=(TraceExporter const&) -> TraceExporter& = delete;
+  TraceExporter(TraceExporter&&) = delete;
+  auto operator=(TraceExporter&&) -> TraceExporter& = delete;
+  ~TraceExporter() { Stop(); }
+
+  // Starts a capture of frames frames, or until Stop with 0.
+  auto Start(std::uint64_t frames = 0) -> gl::errors::Expected<void> {
+    if (IsCapturing()) {
+      return {};
+    }
+    auto const Path = CapturePath();
+    m_File.open(Path, std::ios::binary | std::ios::trunc);
+    if (!m_File) {
+      return std::unexpected(gl::errors::State{
+          std::format("Trace: cannot open {}", Path.string()),
+          gl::errors::ErrorLevel::kError});
+    }
+    ++m_Captures;
+    m_Frames = 0;
+    m_FrameLimit = frames;
+    m_DroppedChunks = 0;
+    m_NamedThreads.clear();
+    m_Origin = Profiler::Now();
+    m_Closing = false;
+    m_Chunk.clear();
+    m_Chunk.reserve(kChunkBytes);
+    Append(
+        "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+        "\"args\":{{\"name\":\"shape\"}}}}");
+    Submit(true);
+    m_Writer = std::thread{[this] { WriterLoop(); }};
+    spdlog::info("Trace capture started: {}", Path.string());
+    return {};
+  }
+  void Stop() {
+    if (!IsCapturing()) {
+      return;
+    }
+    m_Chunk.append("\n]}\n");
+    Submit(true);
+    {
+      std::scoped_lock const Lock{m_Mutex};
+      m_Closing = true;
+    }
+    m_Wake.notify_one();
+    m_Writer.join();
+    m_File.close();
+    if (m_DroppedChunks != 0) {
+      spdlog::warn("Trace capture dropped {} chunks, the disk fell behind",
+                   m_DroppedChunks);
+    }
+    spdlog::info("Trace capture finished after {} frames", m_Frames);
+  }
+  [[nodiscard]] auto IsCapturing() const noexcept -> bool {
+    return m_Writer.joinable();
+  }
+  [[nodiscard]] auto DroppedChunks() const noexcept -> std::uint64_t {
+    return m_DroppedChunks;
+  }
+  // Async-signal-safe; takes effect on the next Frame.
+  void RequestToggle() noexcept {
+    m_ToggleRequested.store(true, std::memory_order_relaxed);
+  }
+
+  // Call once per frame after Profiler::EndFrame. Applies a pending toggle,
+  // then writes the frame's scopes and counters while capturing.
+  void Frame(Profiler const& profiler,
+             std::span<TraceCounter const> counters = {}) {
+    if (m_ToggleRequested.exchange(false, std::memory_order_relaxed)) {
+      if (IsCapturing()) {
+        Stop();
+      } else if (auto Started = Start(); !Started) {
+        Started.error().Handle();
+      }
+    }
+    if (!IsCapturing()) {
+      return;
+    }
+    auto FrameEnd = m_Origin;
+    for (auto const& Sample : profiler.LastFrame()) {
+      auto const Thread =
+          Sample.m_Kind == SampleKind::kGpu ? kGpuTrack : Sample.m_Thread;
+      NameThread(Thread);
+      Append(",\n{{\"name\":\"");
+      AppendName(Sample.m_Name);
+      Append(
+          "\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+          "\"pid\":1,\"tid\":{}}}",
+          Sample.m_Kind == SampleKind::kGpu ? "gpu" : "cpu",
+          Microseconds(Sample.m_Begin),
+          static_cast<double>(Sample.m_Duration) / 1000.0, Thread);
+      EndEvent();
+      FrameEnd = std::max(FrameEnd, Sample.m_Begin + Sample.m_Duration);
+    }
+    for (auto const& Counter : counters) {
+      Append(",\n{{\"name\":\"");
+      AppendName(Counter.m_Name);
+      Append("\",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,\"args\":{{\"value\":{}}}}}",
+             Microseconds(FrameEnd), Counter.m_Value);
+      EndEvent();
+    }
+    ++m_Frames;
+    if (m_FrameLimit != 0 && m_Frames >= m_FrameLimit) {
+      Stop();
+    }
+  }
+};
+
+}  // namespace gl
+#endif
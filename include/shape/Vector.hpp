@@ -1,9 +1,13 @@
 #ifndef SHAPE_VECTOR_HPP
 #define SHAPE_VECTOR_HPP
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <concepts>
 #include <cstddef>
+#include <functional>
+#include <shape/Simd.hpp>
 namespace gl {
 
 template <typename T, std::size_t Dimension>
@@ -57,6 +61,51 @@ template <typename T>
 using Vector3 = decltype(VectorDef<T, 3>());
 template <typename T>
 using Vector4 = decltype(VectorDef<T, 4>());
+namespace detail {
+// Float vectors of three or four lanes take the gl::simd paths at run time;
+// three-vectors are padded to four lanes in registers only, so their memory
+// layout (and every vertex format built from them) stays tightly packed.
+template <typename T, std::size_t Dimension>
+constexpr bool kSimdVector =
+#ifdef SHAPE_SIMD
+    std::same_as<T, float> && (Dimension == 3 || Dimension == 4);
+#else
+    false;
+#endif
+
+#ifdef SHAPE_SIMD
+template <std::size_t Dimension>
+inline auto Load(gl::Vector<float, Dimension> const& value) -> simd::Float4 {
+  if constexpr (Dimension == 4) {
+    return simd::Load(value.m_Values.data());
+  } else {
+    return simd::Load3(value.m_Values.data());
+  }
+}
+template <std::size_t Dimension>
+inline auto Store(simd::Float4 const& value) -> gl::Vector<float, Dimension> {
+  gl::Vector<float, Dimension> Result;
+  if constexpr (Dimension == 4) {
+    simd::Store(Result.m_Values.data(), value);
+  } else {
+    simd::Store3(Result.m_Values.data(), value);
+  }
+  return Result;
+}
+#endif
+
+template <typename T, std::size_t Dimension, typename Operation>
+constexpr auto Componentwise(gl::Vector<T, Dimension> const& lhs,
+                             gl::Vector<T, Dimension> const& rhs,
+                             Operation operation) -> gl::Vector<T, Dimension> {
+  gl::Vector<T, Dimension> Result;
+  for (auto It = 0UZ; It < Dimension; It++) {
+    Result.m_Values[It] = operation(lhs.m_Values[It], rhs.m_Values[It]);
+  }
+  return Result;
+}
+}  // namespace detail
+
 template <typename T, std::size_t Dimension>
   requires requires(T val1, T val2) {
     { val1 + val2 } -> std::same_as<T>;
@@ -64,11 +113,32 @@ template <typename T, std::size_t Dimension>
 constexpr auto operator+(gl::Vector<T, Dimension> const& lhs,
                          gl::Vector<T, Dimension> const& rhs)
     -> gl::Vector<T, Dimension> {
-  gl::Vector<T, Dimension> Temp{};
-  for (auto It = 0z; It < Temp.m_Values.size(); It++) {
-    Temp.m_Values[It] = lhs.m_Values[It] + rhs.m_Values[It];
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return detail::Store<Dimension>(
+          simd::Add(detail::Load(lhs), detail::Load(rhs)));
+    }
   }
-  return Temp;
+#endif
+  return detail::Componentwise(lhs, rhs, std::plus<>{});
+}
+template <typename T, std::size_t Dimension>
+  requires requires(T val1, T val2) {
+    { val1 - val2 } -> std::same_as<T>;
+  }
+constexpr auto operator-(gl::Vector<T, Dimension> const& lhs,
+                         gl::Vector<T, Dimension> const& rhs)
+    -> gl::Vector<T, Dimension> {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return detail::Store<Dimension>(
+          simd::Sub(detail::Load(lhs), detail::Load(rhs)));
+    }
+  }
+#endif
+  return detail::Componentwise(lhs, rhs, std::minus<>{});
 }
 template <typename T, std::size_t Dimension, typename U>
   requires requires(T val1, U val2) {
@@ -76,8 +146,16 @@ template <typename T, std::size_t Dimension, typename U>
   }
 constexpr auto operator*(gl::Vector<T, Dimension> const& lhs, U multiplier)
     -> gl::Vector<T, Dimension> {
-  gl::Vector<T, Dimension> Temp{};
-  for (auto It = 0z; It < Temp.m_Values.size(); It++) {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension> && std::same_as<U, float>) {
+    if !consteval {
+      return detail::Store<Dimension>(
+          simd::Mul(detail::Load(lhs), simd::Splat(multiplier)));
+    }
+  }
+#endif
+  gl::Vector<T, Dimension> Temp;
+  for (auto It = 0UZ; It < Dimension; It++) {
     Temp.m_Values[It] = lhs.m_Values[It] * multiplier;
   }
   return Temp;
@@ -88,11 +166,113 @@ template <typename T, std::size_t Dimension, typename U>
   }
 constexpr auto operator*(U multiplier, gl::Vector<T, Dimension> const& rhs)
     -> gl::Vector<T, Dimension> {
-  gl::Vector<T, Dimension> Temp{};
-  for (auto It = 0z; It < Temp.m_Values.size(); It++) {
-    Temp.m_Values[It] = multiplier * rhs.m_Values[It];
+  if constexpr (std::same_as<U, T>) {
+    return rhs * multiplier;
+  } else {
+    gl::Vector<T, Dimension> Temp;
+    for (auto It = 0UZ; It < Dimension; It++) {
+      Temp.m_Values[It] = multiplier * rhs.m_Values[It];
+    }
+    return Temp;
   }
-  return Temp;
+}
+
+template <typename T, std::size_t Dimension>
+constexpr auto Dot(gl::Vector<T, Dimension> const& lhs,
+                   gl::Vector<T, Dimension> const& rhs) -> T {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return simd::Dot(detail::Load(lhs), detail::Load(rhs));
+    }
+  }
+#endif
+  T Sum{};
+  for (auto It = 0UZ; It < Dimension; It++) {
+    Sum += lhs.m_Values[It] * rhs.m_Values[It];
+  }
+  return Sum;
+}
+template <typename T>
+constexpr auto Cross(gl::Vector<T, 3> const& lhs, gl::Vector<T, 3> const& rhs)
+    -> gl::Vector<T, 3> {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, 3>) {
+    if !consteval {
+      return detail::Store<3>(simd::Cross(detail::Load(lhs), detail::Load(rhs)));
+    }
+  }
+#endif
+  auto const& [Lx, Ly, Lz] = lhs.m_Values;
+  auto const& [Rx, Ry, Rz] = rhs.m_Values;
+  return {{(Ly * Rz) - (Lz * Ry), (Lz * Rx) - (Lx * Rz), (Lx * Ry) - (Ly * Rx)}};
+}
+template <std::floating_point T, std::size_t Dimension>
+auto Length(gl::Vector<T, Dimension> const& value) -> T {
+  return std::sqrt(Dot(value, value));
+}
+// Zero vectors are returned unchanged.
+template <std::floating_point T, std::size_t Dimension>
+auto Normalize(gl::Vector<T, Dimension> const& value)
+    -> gl::Vector<T, Dimension> {
+  auto const SquaredLength = Dot(value, value);
+  if (SquaredLength == T{}) {
+    return value;
+  }
+  return value * (T{1} / std::sqrt(SquaredLength));
+}
+template <typename T, std::size_t Dimension>
+constexpr auto Min(gl::Vector<T, Dimension> const& lhs,
+                   gl::Vector<T, Dimension> const& rhs)
+    -> gl::Vector<T, Dimension> {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return detail::Store<Dimension>(
+          simd::Min(detail::Load(lhs), detail::Load(rhs)));
+    }
+  }
+#endif
+  return detail::Componentwise(lhs, rhs, [](T Left, T Right) -> T {
+    return std::min(Left, Right);
+  });
+}
+template <typename T, std::size_t Dimension>
+constexpr auto Max(gl::Vector<T, Dimension> const& lhs,
+                   gl::Vector<T, Dimension> const& rhs)
+    -> gl::Vector<T, Dimension> {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return detail::Store<Dimension>(
+          simd::Max(detail::Load(lhs), detail::Load(rhs)));
+    }
+  }
+#endif
+  return detail::Componentwise(lhs, rhs, [](T Left, T Right) -> T {
+    return std::max(Left, Right);
+  });
+}
+// Componentwise lhs * rhs + addend, a single fused instruction with FMA.
+template <typename T, std::size_t Dimension>
+constexpr auto MultiplyAdd(gl::Vector<T, Dimension> const& lhs,
+                           gl::Vector<T, Dimension> const& rhs,
+                           gl::Vector<T, Dimension> const& addend)
+    -> gl::Vector<T, Dimension> {
+#ifdef SHAPE_SIMD
+  if constexpr (detail::kSimdVector<T, Dimension>) {
+    if !consteval {
+      return detail::Store<Dimension>(simd::MulAdd(
+          detail::Load(lhs), detail::Load(rhs), detail::Load(addend)));
+    }
+  }
+#endif
+  gl::Vector<T, Dimension> Result;
+  for (auto It = 0UZ; It < Dimension; It++) {
+    Result.m_Values[It] =
+        (lhs.m_Values[It] * rhs.m_Values[It]) + addend.m_Values[It];
+  }
+  return Result;
 }
 }  // namespace gl
 #endif
@@ -0,0 +1,467 @@
+#ifndef SHAPE_VECTORKERNELS_HPP
+#define SHAPE_VECTORKERNELS_HPP
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <shape/Matrix.hpp>
+#include <shape/Point.hpp>
+#include <shape/Vector.hpp>
+#include <span>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHAPE_KERNEL_DISPATCH 1
+#define SHAPE_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace gl {
+
+// Structure-of-arrays view of 3-vectors; all three spans must be equally long.
+struct Vector3Soa {
+  std::span<float> m_X;
+  std::span<float> m_Y;
+  std::span<float> m_Z;
+};
+
+// Instruction sets the span kernels below can run with, picked once at
+// startup from what the CPU reports. Lower ActiveIsa() to compare paths.
+// NOLINTNEXTLINE
+enum struct Isa { kScalar, kSse2, kAvx2, kAvx512 };
+inline auto DetectIsa() -> Isa {
+#ifdef SHAPE_KERNEL_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Isa::kAvx512;
+  }
+  // every AVX2 CPU has F16C too; the half-float packers rely on that
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("f16c")) {
+    return Isa::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return Isa::kSse2;
+  }
+#endif
+  return Isa::kScalar;
+}
+inline auto ActiveIsa() -> Isa& {
+  static auto Active = DetectIsa();
+  return Active;
+}
+// Sets ActiveIsa() for a scope and restores the previous value on the way
+// out, exceptions included.
+class ScopedIsa {
+  Isa m_Previous;
+
+ public:
+  explicit ScopedIsa(Isa isa) : m_Previous(ActiveIsa()) { ActiveIsa() = isa; }
+  ScopedIsa(ScopedIsa const&) = delete;
+  auto operator=(ScopedIsa const&) -> ScopedIsa& = delete;
+  ScopedIsa(ScopedIsa&&) = delete;
+  auto operator=(ScopedIsa&&) -> ScopedIsa& = delete;
+  ~ScopedIsa() { ActiveIsa() = m_Previous; }
+};
+// Calls body(isa) once for every instruction set this CPU supports, from
+// kScalar up, with ActiveIsa() set to it.
+template <std::invocable<Isa> Body>
+void ForEachIsa(Body&& body) {
+  auto const Detected = DetectIsa();
+  for (auto Candidate : {Isa::kScalar, Isa::kSse2, Isa::kAvx2, Isa::kAvx512}) {
+    if (Candidate > Detected) {
+      break;
+    }
+    ScopedIsa const Scope{Candidate};
+    body(Candidate);
+  }
+}
+
+namespace kernels {
+
+static_assert(sizeof(gl::Vector3<float>) == 3 * sizeof(float));
+static_assert(sizeof(gl::Point) == 7 * sizeof(float));
+
+// NOLINTNEXTLINE
+enum struct Op { kAdd, kMultiply };
+
+// The kernels treat arrays as flat float streams. A pattern of Period floats
+// repeats along the stream (3 for Vector3, 7 for Point, 1 for SoA), so with
+// W lanes Period registers hold every lane's operand and each chunk of
+// Period * W floats takes Period loads, operations and stores.
+template <std::size_t Period, std::size_t Width>
+constexpr auto Tile(std::array<float, Period> const& pattern)
+    -> std::array<float, Period * Width> {
+  std::array<float, Period * Width> Tiled{};
+  for (auto It = 0UZ; It < Tiled.size(); ++It) {
+    Tiled[It] = pattern[It % Period];
+  }
+  return Tiled;
+}
+template <Op Operation, std::size_t Period>
+void PatternScalar(float* data, std::size_t count,
+                   std::array<float, Period> const& pattern) {
+  for (auto It = 0UZ; It < count; ++It) {
+    if constexpr (Operation == Op::kAdd) {
+      data[It] += pattern[It % Period];
+    } else {
+      data[It] *= pattern[It % Period];
+    }
+  }
+}
+inline void LerpScalar(float* data, float const* targets, std::size_t count,
+                       float weight) {
+  for (auto It = 0UZ; It < count; ++It) {
+    data[It] += (targets[It] - data[It]) * weight;
+  }
+}
+// Column-major 4x4 matrix applied to points (w = 1) spaced stride floats apart.
+inline void TransformScalar(float* data, std::size_t count, std::size_t stride,
+                            std::array<float, 16> const& matrix) {
+  for (auto Point = 0UZ; Point < count; ++Point) {
+    auto* Values = data + (Point * stride);
+    auto const X = Values[0];
+    auto const Y = Values[1];
+    auto const Z = Values[2];
+    for (auto Row = 0UZ; Row < 3; ++Row) {
+      Values[Row] = (matrix[Row] * X) + (matrix[4 + Row] * Y) +
+                    (matrix[8 + Row] * Z) + matrix[12 + Row];
+    }
+  }
+}
+
+#ifdef SHAPE_KERNEL_DISPATCH
+// Writes the xyz lanes without touching the float after them.
+SHAPE_TARGET("sse2") inline void Store3(float* out, __m128 value) {
+  // NOLINTNEXTLINE
+  _mm_storel_pi(reinterpret_cast<__m64*>(out), value);
+  _mm_store_ss(out + 2, _mm_movehl_ps(value, value));
+}
+
+template <Op Operation, std::size_t Period>
+SHAPE_TARGET("sse2")
+void PatternSse2(float* data, std::size_t count,
+                 std::array<float, Period> const& pattern) {
+  constexpr auto kWidth = 4UZ;
+  auto const Tiled = Tile<Period, kWidth>(pattern);
+  __m128 Operands[Period];  // NOLINT
+  for (auto It = 0UZ; It < Period; ++It) {
+    Operands[It] = _mm_loadu_ps(Tiled.data() + (It * kWidth));
+  }
+  auto Done = 0UZ;
+  for (; Done + (Period * kWidth) <= count; Done += Period * kWidth) {
+    for (auto It = 0UZ; It < Period; ++It) {
+      auto* Slot = data + Done + (It * kWidth);
+      auto const Value = _mm_loadu_ps(Slot);
+      _mm_storeu_ps(Slot, Operation == Op::kAdd
+                              ? _mm_add_ps(Value, Operands[It])
+                              : _mm_mul_ps(Value, Operands[It]));
+    }
+  }
+  PatternScalar<Operation>(data + Done, count - Done, pattern);
+}
+SHAPE_TARGET("sse2")
+inline void LerpSse2(float* data, float const* targets, std::size_t count,
+                     float weight) {
+  auto const Weight = _mm_set1_ps(weight);
+  auto Done = 0UZ;
+  for (; Done + 4 <= count; Done += 4) {
+    auto const Value = _mm_loadu_ps(data + Done);
+    auto const Delta = _mm_sub_ps(_mm_loadu_ps(targets + Done), Value);
+    _mm_storeu_ps(data + Done, _mm_add_ps(Value, _mm_mul_ps(Delta, Weight)));
+  }
+  LerpScalar(data + Done, targets + Done, count - Done, weight);
+}
+SHAPE_TARGET("sse2")
+inline void TransformSse2(float* data, std::size_t count, std::size_t stride,
+                          std::array<float, 16> const& matrix) {
+  auto const Column0 = _mm_loadu_ps(matrix.data());
+  auto const Column1 = _mm_loadu_ps(matrix.data() + 4);
+  auto const Column2 = _mm_loadu_ps(matrix.data() + 8);
+  auto const Column3 = _mm_loadu_ps(matrix.data() + 12);
+  for (auto Point = 0UZ; Point < count; ++Point) {
+    auto* Values = data + (Point * stride);
+    auto const XY = _mm_add_ps(_mm_mul_ps(Column0, _mm_set1_ps(Values[0])),
+                               _mm_mul_ps(Column1, _mm_set1_ps(Values[1])));
+    auto const ZW =
+        _mm_add_ps(_mm_mul_ps(Column2, _mm_set1_ps(Values[2])), Column3);
+    Store3(Values, _mm_add_ps(XY, ZW));
+  }
+}
+
+template <Op Operation, std::size_t Period>
+SHAPE_TARGET("avx2,fma")
+void PatternAvx2(float* data, std::size_t count,
+                 std::array<float, Period> const& pattern) {
+  constexpr auto kWidth = 8UZ;
+  auto const Tiled = Tile<Period, kWidth>(pattern);
+  __m256 Operands[Period];  // NOLINT
+  for (auto It = 0UZ; It < Period; ++It) {
+    Operands[It] = _mm256_loadu_ps(Tiled.data() + (It * kWidth));
+  }
+  auto Done = 0UZ;
+  for (; Done + (Period * kWidth) <= count; Done += Period * kWidth) {
+    for (auto It = 0UZ; It < Period; ++It) {
+      auto* Slot = data + Done + (It * kWidth);
+      auto const Value = _mm256_loadu_ps(Slot);
+      _mm256_storeu_ps(Slot, Operation == Op::kAdd
+                                 ? _mm256_add_ps(Value, Operands[It])
+                                 : _mm256_mul_ps(Value, Operands[It]));
+    }
+  }
+  PatternScalar<Operation>(data + Done, count - Done, pattern);
+}
+SHAPE_TARGET("avx2,fma")
+inline void LerpAvx2(float* data, float const* targets, std::size_t count,
+                     float weight) {
+  auto const Weight = _mm256_set1_ps(weight);
+  auto Done = 0UZ;
+  for (; Done + 8 <= count; Done += 8) {
+    auto const Value = _mm256_loadu_ps(data + Done);
+    auto const Delta = _mm256_sub_ps(_mm256_loadu_ps(targets + Done), Value);
+    _mm256_storeu_ps(data + Done, _mm256_fmadd_ps(Delta, Weight, Value));
+  }
+  LerpScalar(data + Done, targets + Done, count - Done, weight);
+}
+// Two points per iteration, one in each 128-bit half.
+SHAPE_TARGET("avx2,fma")
+inline void TransformAvx2(float* data, std::size_t count, std::size_t stride,
+                          std::array<float, 16> const& matrix) {
+  auto const Column0 = _mm256_broadcast_ps(
+      // NOLINTNEXTLINE
+      reinterpret_cast<__m128 const*>(matrix.data()));
+  // NOLINTNEXTLINE
+  auto const Column1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(
+      matrix.data() + 4));
+  // NOLINTNEXTLINE
+  auto const Column2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(
+      matrix.data() + 8));
+  // NOLINTNEXTLINE
+  auto const Column3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(
+      matrix.data() + 12));
+  auto Point = 0UZ;
+  for (; Point + 2 <= count; Point += 2) {
+    auto* First = data + (Point * stride);
+    auto* Second = First + stride;
+    auto const X =
+        _mm256_set_m128(_mm_set1_ps(Second[0]), _mm_set1_ps(First[0]));
+    auto const Y =
+        _mm256_set_m128(_mm_set1_ps(Second[1]), _mm_set1_ps(First[1]));
+    auto const Z =
+        _mm256_set_m128(_mm_set1_ps(Second[2]), _mm_set1_ps(First[2]));
+    auto Result = _mm256_fmadd_ps(Column0, X, Column3);
+    Result = _mm256_fmadd_ps(Column1, Y, Result);
+    Result = _mm256_fmadd_ps(Column2, Z, Result);
+    Store3(First, _mm256_castps256_ps128(Result));
+    Store3(Second, _mm256_extractf128_ps(Result, 1));
+  }
+  TransformScalar(data + (Point * stride), count - Point, stride, matrix);
+}
+
+template <Op Operation, std::size_t Period>
+SHAPE_TARGET("avx512f")
+void PatternAvx512(float* data, std::size_t count,
+                   std::array<float, Period> const& pattern) {
+  constexpr auto kWidth = 16UZ;
+  auto const Tiled = Tile<Period, kWidth>(pattern);
+  __m512 Operands[Period];  // NOLINT
+  for (auto It = 0UZ; It < Period; ++It) {
+    Operands[It] = _mm512_loadu_ps(Tiled.data() + (It * kWidth));
+  }
+  auto Done = 0UZ;
+  for (; Done + (Period * kWidth) <= count; Done += Period * kWidth) {
+    for (auto It = 0UZ; It < Period; ++It) {
+      auto* Slot = data + Done + (It * kWidth);
+      auto const Value = _mm512_loadu_ps(Slot);
+      _mm512_storeu_ps(Slot, Operation == Op::kAdd
+                                 ? _mm512_add_ps(Value, Operands[It])
+                                 : _mm512_mul_ps(Value, Operands[It]));
+    }
+  }
+  PatternScalar<Operation>(data + Done, count - Done, pattern);
+}
+SHAPE_TARGET("avx512f")
+inline void LerpAvx512(float* data, float const* targets, std::size_t count,
+                       float weight) {
+  auto const Weight = _mm512_set1_ps(weight);
+  auto Done = 0UZ;
+  for (; Done + 16 <= count; Done += 16) {
+    auto const Value = _mm512_loadu_ps(data + Done);
+    auto const Delta = _mm512_sub_ps(_mm512_loadu_ps(targets + Done), Value);
+    _mm512_storeu_ps(data + Done, _mm512_fmadd_ps(Delta, Weight, Value));
+  }
+  LerpScalar(data + Done, targets + Done, count - Done, weight);
+}
+#endif
+
+template <Op Operation, std::size_t Period>
+void Pattern(float* data, std::size_t count,
+             std::array<float, Period> const& pattern) {
+#ifdef SHAPE_KERNEL_DISPATCH
+  switch (ActiveIsa()) {
+    case Isa::kAvx512:
+      return PatternAvx512<Operation>(data, count, pattern);
+    case Isa::kAvx2:
+      return PatternAvx2<Operation>(data, count, pattern);
+    case Isa::kSse2:
+      return PatternSse2<Operation>(data, count, pattern);
+    case Isa::kScalar:
+      break;
+  }
+#endif
+  PatternScalar<Operation>(data, count, pattern);
+}
+inline void Lerp(float* data, float const* targets, std::size_t count,
+                 float weight) {
+#ifdef SHAPE_KERNEL_DISPATCH
+  switch (ActiveIsa()) {
+    case Isa::kAvx512:
+      return LerpAvx512(data, targets, count, weight);
+    case Isa::kAvx2:
+      return LerpAvx2(data, targets, count, weight);
+    case Isa::kSse2:
+      return LerpSse2(data, targets, count, weight);
+    case Isa::kScalar:
+      break;
+  }
+#endif
+  LerpScalar(data, targets, count, weight);
+}
+inline void Transform(float* data, std::size_t count, std::size_t stride,
+                      std::array<float, 16> const& matrix) {
+#ifdef SHAPE_KERNEL_DISPATCH
+  switch (ActiveIsa()) {
+    case Isa::kAvx512:  // 4-wide columns gain nothing from 512-bit lanes
+    case Isa::kAvx2:
+      return TransformAvx2(data, count, stride, matrix);
+    case Isa::kSse2:
+      return TransformSse2(data, count, stride, matrix);
+    case Isa::kScalar:
+      break;
+  }
+#endif
+  TransformScalar(data, count, stride, matrix);
+}
+
+template <typename T>
+auto Floats(std::span<T> values) -> float* {
+  // NOLINTNEXTLINE
+  return reinterpret_cast<float*>(values.data());
+}
+template <typename T>
+auto Floats(std::span<T const> values) -> float const* {
+  // NOLINTNEXTLINE
+  return reinterpret_cast<float const*>(values.data());
+}
+inline void CheckSizes(std::size_t lhs, std::size_t rhs) {
+  if (lhs != rhs) {
+    throw std::invalid_argument("Span sizes differ");
+  }
+}
+inline void CheckSizes(Vector3Soa const& values) {
+  CheckSizes(values.m_X.size(), values.m_Y.size());
+  CheckSizes(values.m_X.size(), values.m_Z.size());
+}
+}  // namespace kernels
+
+// Bulk operations over whole arrays. On x86 they run with the widest of
+// SSE2, AVX2 + FMA or AVX-512 the CPU supports; elsewhere as plain loops.
+inline void AddInPlace(std::span<gl::Vector3<float>> values,
+                       gl::Vector3<float> const& offset) {
+  kernels::Pattern<kernels::Op::kAdd>(kernels::Floats(values),
+                                      values.size() * 3, offset.m_Values);
+}
+// Moves the positions; colors are left alone.
+inline void AddInPlace(std::span<gl::Point> points,
+                       gl::Vector3<float> const& offset) {
+  auto const& [X, Y, Z] = offset.m_Values;
+  kernels::Pattern<kernels::Op::kAdd>(
+      kernels::Floats(points), points.size() * 7,
+      std::array<float, 7>{X, Y, Z, 0.0F, 0.0F, 0.0F, 0.0F});
+}
+inline void AddInPlace(Vector3Soa const& values,
+                       gl::Vector3<float> const& offset) {
+  kernels::CheckSizes(values);
+  auto const& [X, Y, Z] = offset.m_Values;
+  kernels::Pattern<kernels::Op::kAdd>(values.m_X.data(), values.m_X.size(),
+                                      std::array{X});
+  kernels::Pattern<kernels::Op::kAdd>(values.m_Y.data(), values.m_Y.size(),
+                                      std::array{Y});
+  kernels::Pattern<kernels::Op::kAdd>(values.m_Z.data(), values.m_Z.size(),
+                                      std::array{Z});
+}
+
+inline void Scale(std::span<gl::Vector3<float>> values,
+                  gl::Vector3<float> const& factors) {
+  kernels::Pattern<kernels::Op::kMultiply>(
+      kernels::Floats(values), values.size() * 3, factors.m_Values);
+}
+inline void Scale(std::span<gl::Vector3<float>> values, float factor) {
+  Scale(values, gl::Vector3<float>{{factor, factor, factor}});
+}
+// Scales the positions about the origin; colors are left alone.
+inline void Scale(std::span<gl::Point> points,
+                  gl::Vector3<float> const& factors) {
+  auto const& [X, Y, Z] = factors.m_Values;
+  kernels::Pattern<kernels::Op::kMultiply>(
+      kernels::Floats(points), points.size() * 7,
+      std::array<float, 7>{X, Y, Z, 1.0F, 1.0F, 1.0F, 1.0F});
+}
+inline void Scale(Vector3Soa const& values, float factor) {
+  kernels::CheckSizes(values);
+  for (auto Component : {values.m_X, values.m_Y, values.m_Z}) {
+    kernels::Pattern<kernels::Op::kMultiply>(Component.data(),
+                                             Component.size(),
+                                             std::array{factor});
+  }
+}
+
+// Applies a column-major affine 4x4 matrix to positions (w = 1). The bottom
+// row is ignored, so there is no perspective divide.
+inline void TransformByMatrix(std::span<gl::Vector3<float>> values,
+                              std::array<float, 16> const& matrix) {
+  kernels::Transform(kernels::Floats(values), values.size(), 3, matrix);
+}
+inline void TransformByMatrix(std::span<gl::Point> points,
+                              std::array<float, 16> const& matrix) {
+  kernels::Transform(kernels::Floats(points), points.size(), 7, matrix);
+}
+inline void TransformByMatrix(std::span<gl::Vector3<float>> values,
+                              gl::Mat4<float> const& matrix) {
+  TransformByMatrix(values, std::bit_cast<std::array<float, 16>>(matrix));
+}
+inline void TransformByMatrix(std::span<gl::Point> points,
+                              gl::Mat4<float> const& matrix) {
+  TransformByMatrix(points, std::bit_cast<std::array<float, 16>>(matrix));
+}
+
+// values[i] += (targets[i] - values[i]) * weight
+inline void Lerp(std::span<gl::Vector3<float>> values,
+                 std::span<gl::Vector3<float> const> targets, float weight) {
+  kernels::CheckSizes(values.size(), targets.size());
+  kernels::Lerp(kernels::Floats(values), kernels::Floats(targets),
+                values.size() * 3, weight);
+}
+// Blends positions and colors alike.
+inline void Lerp(std::span<gl::Point> points,
+                 std::span<gl::Point const> targets, float weight) {
+  kernels::CheckSizes(points.size(), targets.size());
+  kernels::Lerp(kernels::Floats(points), kernels::Floats(targets),
+                points.size() * 7, weight);
+}
+inline void Lerp(Vector3Soa const& values, Vector3Soa const& targets,
+                 float weight) {
+  kernels::CheckSizes(values);
+  kernels::CheckSizes(targets);
+  kernels::CheckSizes(values.m_X.size(), targets.m_X.size());
+  kernels::Lerp(values.m_X.data(), targets.m_X.data(), values.m_X.size(),
+                weight);
+  kernels::Lerp(values.m_Y.data(), targets.m_Y.data(), values.m_Y.size(),
+                weight);
+  kernels::Lerp(values.m_Z.data(), targets.m_Z.data(), values.m_Z.size(),
+                weight);
+}
+
+}  // namespace gl
+#endif
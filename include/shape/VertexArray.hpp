@@ -1,22 +1,41 @@
+#ifndef SHAPE_VERTEXARRAY_HPP
+#define SHAPE_VERTEXARRAY_HPP
 #include <glad/glad.h>
 
 #include <expected>
 #include <optional>
 #include <shape/Errors.hpp>
+#include <shape/StateCache.hpp>
 namespace gl {
 inline auto GenVertexArray() -> GLuint {
   GLuint RetVal{};
   glGenVertexArrays(1, &RetVal);
   return RetVal;
 };
+inline auto CreateVertexArray() -> GLuint {
+  GLuint RetVal{};
+  glCreateVertexArrays(1, &RetVal);
+  return RetVal;
+};
+
+// Layout of one vertex attribute, see VertexArray::Attrib.
+struct AttribFormat {
+  GLuint m_Location{};
+  GLint m_Components{};
+  GLenum m_Type{GL_FLOAT};
+  bool m_Normalized{false};
+  GLuint m_RelativeOffset{};
+  bool m_Integer{false};  // read as ivec/uvec instead of converting to float
+};
 
 class VertexArray {
   GLuint m_id;
 
  public:
-  VertexArray() : m_id{GenVertexArray()} {}
+  VertexArray() : m_id{CreateVertexArray()} {}
   ~VertexArray() {
     if (m_id != 0) {
+      StateCache::Instance().ForgetVertexArray(m_id);
       glDeleteVertexArrays(1, &(m_id));
     }
   }
@@ -27,6 +46,7 @@ class VertexArray {
   };
   auto operator=(VertexArray &&other) noexcept -> VertexArray & {
     if (m_id != 0) {
+      StateCache::Instance().ForgetVertexArray(m_id);
       glDeleteVertexArrays(1, &m_id);
     }
     m_id = other.m_id;
@@ -39,12 +59,38 @@ class VertexArray {
   // NOLINTNEXTLINE
   [[nodiscard]] auto Bind() noexcept -> gl::errors::Expected<void> {
     if (m_id != 0) {
-      glBindVertexArray(m_id);
+      StateCache::Instance().BindVertexArray(m_id);
       return {};
     }
     return std::unexpected(errors::State{"No VertexArray in this object",
                                          errors::ErrorLevel::kWarning});
   }
-  static auto Unbind() -> void { glBindVertexArray(0); }
+  static auto Unbind() -> void { StateCache::Instance().BindVertexArray(0); }
+
+  // Direct state access setup, none of these touch the current binding.
+  auto VertexBuffer(GLuint bindingIndex, GLuint buffer, GLintptr offset,
+                    GLsizei stride) -> void {
+    glVertexArrayVertexBuffer(m_id, bindingIndex, buffer, offset, stride);
+  }
+  auto ElementBuffer(GLuint buffer) -> void {
+    glVertexArrayElementBuffer(m_id, buffer);
+  }
+  auto Attrib(AttribFormat const &format, GLuint bindingIndex) -> void {
+    if (format.m_Integer) {
+      glVertexArrayAttribIFormat(m_id, format.m_Location, format.m_Components,
+                                 format.m_Type, format.m_RelativeOffset);
+    } else {
+      glVertexArrayAttribFormat(m_id, format.m_Location, format.m_Components,
+                                format.m_Type,
+                                format.m_Normalized ? GL_TRUE : GL_FALSE,
+                                format.m_RelativeOffset);
+    }
+    glVertexArrayAttribBinding(m_id, format.m_Location, bindingIndex);
+    glEnableVertexArrayAttrib(m_id, format.m_Location);
+  }
+  auto BindingDivisor(GLuint bindingIndex, GLuint divisor) -> void {
+    glVertexArrayBindingDivisor(m_id, bindingIndex, divisor);
+  }
 };
 }  // namespace gl
+#endif
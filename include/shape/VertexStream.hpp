@@ -0,0 +1,303 @@
+#ifndef SHAPE_VERTEXSTREAM_HPP
+#define SHAPE_VERTEXSTREAM_HPP
+#include <glad/glad.h>  //
+//
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <shape/Buffer.hpp>
+#include <shape/Color.hpp>
+#include <shape/Vector.hpp>
+#include <shape/VertexArray.hpp>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+namespace gl {
+
+// How a VertexStream lays its attributes out on the GPU: one buffer per
+// attribute, or every attribute of a vertex next to each other in one buffer.
+enum struct Interleaving : std::uint8_t { kSeparate, kInterleaved };
+
+// GL format of a C++ attribute type. Specialise it to make a new type usable
+// in a VertexLayout or VertexStream.
+template <typename T>
+struct AttribTraits;
+template <std::size_t Dimension>
+struct AttribTraits<Vector<float, Dimension>> {
+  static constexpr GLint kComponents = Dimension;
+  static constexpr GLenum kType = GL_FLOAT;
+  static constexpr bool kNormalized = false;
+  static constexpr bool kInteger = false;
+};
+template <std::size_t Dimension>
+struct AttribTraits<Vector<int, Dimension>> {
+  static constexpr GLint kComponents = Dimension;
+  static constexpr GLenum kType = GL_INT;
+  static constexpr bool kNormalized = false;
+  static constexpr bool kInteger = true;
+};
+template <std::size_t Dimension>
+struct AttribTraits<Vector<unsigned, Dimension>> {
+  static constexpr GLint kComponents = Dimension;
+  static constexpr GLenum kType = GL_UNSIGNED_INT;
+  static constexpr bool kNormalized = false;
+  static constexpr bool kInteger = true;
+};
+template <>
+struct AttribTraits<float> : AttribTraits<Vector<float, 1>> {};
+// Components go to the shader in declaration order, i.e. red, blue, green,
+// alpha; the default shaders only pass colors through.
+template <>
+struct AttribTraits<ColorFloat> : AttribTraits<Vector<float, 4>> {};
+// RGBA8, read by the shader as a vec4 in [0, 1].
+template <>
+struct AttribTraits<ColorInt> {
+  static constexpr GLint kComponents = 4;
+  static constexpr GLenum kType = GL_UNSIGNED_BYTE;
+  static constexpr bool kNormalized = true;
+  static constexpr bool kInteger = false;
+};
+
+template <typename T>
+concept VertexAttribute =
+    std::is_trivially_copyable_v<T> && requires { AttribTraits<T>::kType; };
+
+// Attribute formats of one vertex plus where each attribute lives: with
+// kInterleaved everything shares binding 0 at increasing relative offsets,
+// with kSeparate attribute i reads binding i at offset 0.
+class VertexLayout {
+  std::vector<AttribFormat> m_Attribs;
+  std::vector<GLsizei> m_Sizes;
+  Interleaving m_Interleaving;
+  GLsizei m_Stride{};
+
+ public:
+  // GL wants attribute offsets and strides on 4 byte boundaries
+  static constexpr GLsizei kAlignment = 4;
+
+  explicit VertexLayout(Interleaving interleaving)
+      : m_Interleaving{interleaving} {}
+
+  // m_RelativeOffset of format is ignored and computed from the layout.
+  auto Add(AttribFormat format, GLsizei bytes) -> VertexLayout& {
+    format.m_RelativeOffset =
+        m_Interleaving == Interleaving::kInterleaved
+            ? static_cast<GLuint>(m_Stride)
+            : 0U;
+    m_Stride += (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    m_Attribs.push_back(format);
+    m_Sizes.push_back(bytes);
+    return *this;
+  }
+  template <VertexAttribute T>
+  auto Add(GLuint location) -> VertexLayout& {
+    using Traits = AttribTraits<T>;
+    return Add({.m_Location = location,
+                .m_Components = Traits::kComponents,
+                .m_Type = Traits::kType,
+                .m_Normalized = Traits::kNormalized,
+                .m_Integer = Traits::kInteger},
+               sizeof(T));
+  }
+
+  [[nodiscard]] auto Mode() const noexcept -> Interleaving {
+    return m_Interleaving;
+  }
+  [[nodiscard]] auto Attribs() const noexcept -> std::span<AttribFormat const> {
+    return m_Attribs;
+  }
+  [[nodiscard]] auto Bindings() const noexcept -> std::size_t {
+    return m_Interleaving == Interleaving::kInterleaved ? 1 : m_Attribs.size();
+  }
+  [[nodiscard]] auto BindingOf(std::size_t attrib) const noexcept -> GLuint {
+    return m_Interleaving == Interleaving::kInterleaved
+               ? 0U
+               : static_cast<GLuint>(attrib);
+  }
+  // Distance between two vertices in the buffer of binding.
+  [[nodiscard]] auto Stride(GLuint binding = 0) const -> GLsizei {
+    return m_Interleaving == Interleaving::kInterleaved ? m_Stride
+                                                        : m_Sizes.at(binding);
+  }
+
+  // Points every binding at its buffer and sets up all attribute formats.
+  void Apply(VertexArray& vertexArray, std::span<GLuint const> buffers) const {
+    if (buffers.size() != Bindings()) {
+      throw std::invalid_argument("VertexLayout::Apply: one buffer per binding");
+    }
+    for (auto Binding = 0U; Binding < buffers.size(); ++Binding) {
+      vertexArray.VertexBuffer(Binding, buffers[Binding], 0, Stride(Binding));
+    }
+    for (auto Attrib = 0UZ; Attrib < m_Attribs.size(); ++Attrib) {
+      vertexArray.Attrib(m_Attribs[Attrib], BindingOf(Attrib));
+    }
+  }
+};
+
+// Vertices kept as one CPU array per attribute and mirrored to the GPU either
+// separately or interleaved. Writes are tracked per attribute: with
+// kSeparate, Upload only sends the changed range of the changed attributes, so
+// moving positions every frame never re-sends colors. kInterleaved sends whole
+// vertices and suits data that changes together or not at all.
+template <VertexAttribute... Attributes>
+class VertexStream {
+ public:
+  static constexpr auto kAttributes = sizeof...(Attributes);
+  template <std::size_t Index>
+  using Element = std::tuple_element_t<Index, std::tuple<Attributes...>>;
+
+ private:
+  static constexpr auto kClean = std::numeric_limits<std::size_t>::max();
+  struct DirtyRange {
+    std::size_t m_Begin{kClean};
+    std::size_t m_End{};
+  };
+
+  VertexLayout m_Layout;
+  gl::VertexArray m_VertexArray;
+  std::array<Buffer<BufferType::kArray>, kAttributes> m_Buffers;
+  std::tuple<std::vector<Attributes>...> m_Data;
+  std::array<DirtyRange, kAttributes> m_Dirty{};
+  std::vector<std::byte> m_Staging;  // packed vertices for kInterleaved
+  std::size_t m_Size{};
+  std::size_t m_Capacity{};  // in vertices, as allocated on the GPU
+  Usage m_Usage;
+
+  void MarkDirty(std::size_t attrib, std::size_t first, std::size_t last) {
+    auto& Range = m_Dirty.at(attrib);
+    Range.m_Begin = std::min(Range.m_Begin, first);
+    Range.m_End = std::max(Range.m_End, last);
+  }
+  template <std::size_t Index>
+  void UploadSeparate() {
+    auto& Range = m_Dirty[Index];
+    if (Range.m_Begin >= Range.m_End) {
+      return;
+    }
+    m_Buffers[Index].SubData(
+        Range.m_Begin, std::span<Element<Index> const>(std::get<Index>(m_Data))
+                           .subspan(Range.m_Begin, Range.m_End - Range.m_Begin));
+    Range = {};
+  }
+  template <std::size_t Index>
+  void Pack(std::size_t first, std::size_t last) {
+    auto const Offset = m_Layout.Attribs()[Index].m_RelativeOffset;
+    auto const Stride = static_cast<std::size_t>(m_Layout.Stride());
+    auto const& Source = std::get<Index>(m_Data);
+    for (auto Vertex = first; Vertex < last; ++Vertex) {
+      std::memcpy(&m_Staging[((Vertex - first) * Stride) + Offset],
+                  &Source[Vertex], sizeof(Element<Index>));
+    }
+  }
+  void UploadInterleaved() {
+    DirtyRange Union;
+    for (auto& Range : m_Dirty) {
+      Union.m_Begin = std::min(Union.m_Begin, Range.m_Begin);
+      Union.m_End = std::max(Union.m_End, Range.m_End);
+      Range = {};
+    }
+    if (Union.m_Begin >= Union.m_End) {
+      return;
+    }
+    auto const Stride = static_cast<std::size_t>(m_Layout.Stride());
+    m_Staging.resize((Union.m_End - Union.m_Begin) * Stride);
+    [&]<std::size_t... Index>(std::index_sequence<Index...>) {
+      (Pack<Index>(Union.m_Begin, Union.m_End), ...);
+    }(std::index_sequence_for<Attributes...>{});
+    m_Buffers[0].SubData(Union.m_Begin * Stride, m_Staging);
+  }
+
+ public:
+  // locations[i] is the shader location of the i-th attribute type.
+  VertexStream(Interleaving interleaving,
+               std::array<GLuint, kAttributes> const& locations,
+               Usage usage = Usage::kDynamicDraw)
+      : m_Layout{interleaving}, m_Usage{usage} {
+    [&]<std::size_t... Index>(std::index_sequence<Index...>) {
+      (m_Layout.template Add<Attributes>(locations[Index]), ...);
+    }(std::index_sequence_for<Attributes...>{});
+    std::array<GLuint, kAttributes> Names{};
+    std::ranges::transform(m_Buffers, Names.begin(),
+                           [](auto const& Entry) { return Entry.Get(); });
+    m_Layout.Apply(m_VertexArray,
+                   std::span(Names).first(m_Layout.Bindings()));
+  }
+
+  [[nodiscard]] auto Layout() const noexcept -> VertexLayout const& {
+    return m_Layout;
+  }
+  // The vertex array reading this stream, e.g. to attach an element buffer.
+  [[nodiscard]] auto Array() noexcept -> gl::VertexArray& {
+    return m_VertexArray;
+  }
+  [[nodiscard]] auto Size() const noexcept -> std::size_t { return m_Size; }
+
+  // New vertices are value-initialised and uploaded with the next Upload.
+  void Resize(std::size_t vertices) {
+    std::apply([vertices](auto&... Arrays) { (Arrays.resize(vertices), ...); },
+               m_Data);
+    for (auto Attrib = 0UZ; Attrib < kAttributes; ++Attrib) {
+      if (vertices > m_Size) {
+        MarkDirty(Attrib, m_Size, vertices);
+      }
+      m_Dirty[Attrib].m_End = std::min(m_Dirty[Attrib].m_End, vertices);
+    }
+    m_Size = vertices;
+  }
+
+  template <std::size_t Index>
+  [[nodiscard]] auto Get() const noexcept -> std::span<Element<Index> const> {
+    return std::get<Index>(m_Data);
+  }
+  template <std::size_t Index>
+  void Set(std::size_t vertex, Element<Index> const& value) {
+    std::get<Index>(m_Data).at(vertex) = value;
+    MarkDirty(Index, vertex, vertex + 1);
+  }
+  template <std::size_t Index>
+  void Write(std::size_t first, std::span<Element<Index> const> values) {
+    if (first + values.size() > m_Size) {
+      throw std::out_of_range("VertexStream::Write past the last vertex");
+    }
+    std::ranges::copy(values, std::get<Index>(m_Data).begin() +
+                                  static_cast<std::ptrdiff_t>(first));
+    MarkDirty(Index, first, first + values.size());
+  }
+
+  // Grows the GPU storage when needed and sends everything written since the
+  // last call.
+  void Upload() {
+    if (m_Size > m_Capacity) {
+      auto NewCapacity = std::max<std::size_t>(m_Capacity, 64);
+      while (NewCapacity < m_Size) {
+        NewCapacity *= 2;
+      }
+      for (auto Binding = 0U; Binding < m_Layout.Bindings(); ++Binding) {
+        m_Buffers[Binding].Allocate(
+            NewCapacity * static_cast<std::size_t>(m_Layout.Stride(Binding)),
+            m_Usage);
+      }
+      m_Capacity = NewCapacity;
+      // the storage was re-specified, everything has to be uploaded again
+      for (auto Attrib = 0UZ; Attrib < kAttributes; ++Attrib) {
+        m_Dirty[Attrib] = {.m_Begin = 0, .m_End = m_Size};
+      }
+    }
+    if (m_Layout.Mode() == Interleaving::kInterleaved) {
+      UploadInterleaved();
+      return;
+    }
+    [&]<std::size_t... Index>(std::index_sequence<Index...>) {
+      (UploadSeparate<Index>(), ...);
+    }(std::index_sequence_for<Attributes...>{});
+  }
+};
+
+}  // namespace gl
+#endif
@@ -7,18 +7,42 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
-#include <ranges>
+#include <optional>
+#include <string_view>
+#include <thread>
 #include <shape/Buffer.hpp>
 #include <shape/Color.hpp>
 #include <shape/Drawer.hpp>
 #include <shape/Errors.hpp>
+#include <shape/FixedTimestep.hpp>
+#include <shape/FramePacer.hpp>
+#include <shape/FramePacket.hpp>
+#include <shape/FramePipeline.hpp>
+#include <shape/FrameStats.hpp>
+#include <shape/InstancedMesh.hpp>
+#include <shape/JobSystem.hpp>
 #include <shape/Point.hpp>
+#include <shape/Profiler.hpp>
+#include <shape/QuadBatch.hpp>
 #include <shape/Rectangle.hpp>
+#include <shape/RenderQueue.hpp>
 #include <shape/Shader.hpp>
+#include <shape/ShaderCache.hpp>
+#include <shape/StateCache.hpp>
+#include <shape/TraceExporter.hpp>
 #include <shape/Vector.hpp>
+#include <shape/VertexArray.hpp>
+#include <vector>
 
 namespace gl {
 namespace {
@@ -26,23 +50,122 @@ namespace {
 // Window dimensions
 constexpr unsigned kStartingWidth = 800;
 constexpr unsigned kStartingHeight = 600;
+// Frames between two profiler and draw statistics summaries in the debug log
+constexpr std::uint64_t kProfileReportFrames = 600;
+// Frames in flight between update and submit, SHAPE_PIPELINE_DEPTH=N
+// overrides it; 1 trades the overlap for a frame less of latency
+constexpr std::size_t kPipelineDepth = 2;
+// Frames the GPU may lag behind, SHAPE_FRAMES_IN_FLIGHT=N overrides it.
+// SHAPE_TARGET_FPS=N paces frames to N per second instead of vsync.
+constexpr std::size_t kFramesInFlight = 2;
+// The chessboard covers the whole window in 8 x 8 squares
+constexpr std::size_t kBoardWidth = 8;
+constexpr float kSquareSize = 2.0F / static_cast<float>(kBoardWidth);
+
+// Terminates GLFW on scope exit. Declared before any GL object in main so
+// their destructors still run with a live context.
+struct GlfwSession {
+  GlfwSession() = default;
+  GlfwSession(GlfwSession const&) = delete;
+  GlfwSession(GlfwSession&&) = delete;
+  auto operator=(GlfwSession const&) -> GlfwSession& = delete;
+  auto operator=(GlfwSession&&) -> GlfwSession& = delete;
+  ~GlfwSession() { glfwTerminate(); }
+};
+
+// Trace capture toggled by SIGUSR1 or F12; SHAPE_TRACE_FRAMES=N captures the
+// first N frames on startup.
+// NOLINTNEXTLINE
+std::atomic<TraceExporter*> TraceTarget{nullptr};
+extern "C" void ToggleTraceOnSignal(int /*signal*/) {
+  if (auto* Target = TraceTarget.load(); Target != nullptr) {
+    Target->RequestToggle();
+  }
+}
+// Offset of the grid, bouncing around the window. Advanced in fixed steps,
+// drawn interpolated between the last two of them.
+struct GridMotion {
+  Vector2<float> m_Previous{{0.0F, 0.0F}};
+  Vector2<float> m_Current{{0.0F, 0.0F}};
+  Vector2<float> m_Velocity{{0.0F, 0.0F}};
+
+  void Step(std::chrono::nanoseconds step) {
+    m_Previous = m_Current;
+    auto const Seconds = std::chrono::duration<float>{step}.count();
+    m_Current = (m_Velocity * Seconds) + m_Current;
+    if (m_Current.X() > 1.0F) {
+      m_Current.X() = 2 - m_Current.X();
+      m_Velocity.X() *= -1;
+    }
+    if (m_Current.X() < 0.0F) {
+      m_Current.X() = -m_Current.X();
+      m_Velocity.X() *= -1;
+    }
+    // NOLINTNEXTLINE
+    if (m_Current.Y() > 1.7F) {
+      // NOLINTNEXTLINE
+      m_Current.Y() = 3.4F - m_Current.Y();
+      m_Velocity.Y() *= -1;
+    }
+    if (m_Current.Y() < 0.0F) {
+      m_Current.Y() = -m_Current.Y();
+      m_Velocity.Y() *= -1;
+    }
+  }
+  [[nodiscard]] auto At(float alpha) const -> Vector2<float> {
+    return ((m_Current - m_Previous) * alpha) + m_Previous;
+  }
+};
+
+// The cursor in normalized device coordinates; event thread only.
+auto CursorPosition(GLFWwindow& window) -> Vector2<float> {
+  auto X = 0.0;
+  auto Y = 0.0;
+  auto Width = 0;
+  auto Height = 0;
+  glfwGetCursorPos(&window, &X, &Y);
+  glfwGetWindowSize(&window, &Width, &Height);
+  if (Width <= 0 || Height <= 0) {
+    return {{-2.0F, -2.0F}};
+  }
+  return {{static_cast<float>((2.0 * X / Width) - 1.0),
+           static_cast<float>(1.0 - (2.0 * Y / Height))}};
+}
+// The chessboard square at position, counted from the bottom left corner, or
+// std::nullopt outside the board.
+auto SquareAt(Vector2<float> position) -> std::optional<std::size_t> {
+  auto const Column = std::floor((position.X() + 1.0F) / kSquareSize);
+  auto const Row = std::floor((position.Y() + 1.0F) / kSquareSize);
+  auto const Width = static_cast<float>(kBoardWidth);
+  if (Column < 0.0F || Row < 0.0F || Column >= Width || Row >= Width) {
+    return std::nullopt;
+  }
+  return (static_cast<std::size_t>(Row) * kBoardWidth) +
+         static_cast<std::size_t>(Column);
+}
+
+auto NumberFromEnvironment(char const* name) -> std::uint64_t {
+  // NOLINTNEXTLINE
+  char const* Value = std::getenv(name);
+  std::uint64_t Number{};
+  if (Value != nullptr) {
+    std::string_view const Text{Value};
+    std::from_chars(Text.data(), Text.data() + Text.size(), Number);
+  }
+  return Number;
+}
 
 }  // namespace
 }  // namespace gl
 constexpr auto kStartingScaleFactor = 1.0F / 2;
 
 auto main() -> int {
-  // Resize callback function
-  // NOLINTNEXTLINE
-  auto FramebufferSizeCallback = [](GLFWwindow* /*window*/, int width,
-                                    int height) {
-    glViewport(0, 0, width, height);
-  };
   // Initialize GLFW
   if (glfwInit() == 0) {
     std::cerr << "Failed to initialize GLFW\n";
     return -1;
   }
+  gl::GlfwSession const Session;
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);  // NOLINT
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -55,16 +178,12 @@ auto main() -> int {
                        "Resizable OpenGL Window", nullptr, nullptr);
   if (Window == nullptr) {
     std::cerr << "Failed to create GLFW window\n";
-    glfwTerminate();
     return -1;
   }
 
   // Make context current
   glfwMakeContextCurrent(Window);
 
-  // Set the resize callback
-  glfwSetFramebufferSizeCallback(Window, FramebufferSizeCallback);
-
   // Initialize GLAD
   if (gladLoadGL() == 0) {
     std::cerr << "Failed to initialize GLAD\n";
@@ -72,9 +191,12 @@ auto main() -> int {
   }
 
   glDebugMessageCallback(gl::errors::DebugCallback, nullptr);
+  gl::ShaderCache::Instance().SetBinaryCache(
+      std::filesystem::temp_directory_path() / "OpenGLLearning" / "programs");
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  auto& State = gl::StateCache::Instance();
+  State.SetBlend(true);
+  State.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   constexpr auto kNumOfVert = 6;
   constexpr auto kPositions = std::array{
       gl::Point{.m_Position = {{-1.0F, -1.0F, 0.0F}},
@@ -87,75 +209,63 @@ auto main() -> int {
                 .m_Color = {.red = {0.0F}, .blue = {1.0F}, .alpha = {0.2F}}}};
 
   constexpr auto kIndices = std::array{0U, 1U, 2U, 0U, 2U, 3U};
-  unsigned int buffer;  // NOLINT
-  unsigned int EBO{};
-  unsigned int VAO = 0;
-  glGenVertexArrays(1, &VAO);
-  glBindVertexArray(VAO);
-
-  glGenBuffers(1, &buffer);
-  glBindBuffer(GL_ARRAY_BUFFER, buffer);
-  gl::BufferData(gl::BufferType::kArray, kPositions, gl::Usage::kStaticDraw);
-  glGenBuffers(1, &EBO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  gl::BufferData(gl::BufferType::kElementArray, kIndices,
-                 gl::Usage::kStaticDraw);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(gl::Point), nullptr);
-  glEnableVertexAttribArray(0);
-
-  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(gl::Point),
-                        // NOLINTNEXTLINE
-                        reinterpret_cast<void*>(sizeof(gl::Vector3<float>)));
-  glEnableVertexAttribArray(1);
-  auto Result = CreateShaderFromFile(std::filesystem::current_path() / "glsl" /
-                                         "newBaseVertexShader.vert.glsl",
-                                     std::filesystem::current_path() / "glsl" /
-                                         "ourColourFragmentShader.frag.glsl");
+  gl::Buffer<gl::BufferType::kArray> GridVertices{kPositions,
+                                                  gl::Usage::kStaticDraw};
+  gl::Buffer<gl::BufferType::kElementArray> GridIndices{kIndices,
+                                                        gl::Usage::kStaticDraw};
+  gl::VertexArray GridVertexArray;
+  GridVertexArray.VertexBuffer(0, GridVertices.Get(), 0, sizeof(gl::Point));
+  GridVertexArray.ElementBuffer(GridIndices.Get());
+  GridVertexArray.Attrib({.m_Location = 0, .m_Components = 3}, 0);
+  GridVertexArray.Attrib({.m_Location = 1,
+                          .m_Components = 4,
+                          .m_RelativeOffset = offsetof(gl::Point, m_Color)},
+                         0);
+  auto Result = gl::ShaderCache::Instance().GetFromFiles(
+      std::filesystem::current_path() / "glsl" /
+          "newBaseVertexShader.vert.glsl",
+      std::filesystem::current_path() / "glsl" /
+          "ourColourFragmentShader.frag.glsl");
   if (!Result.has_value()) {
     Result.error().Handle();
     return (2);
   }
-  int const OffsetVertexLocation = glGetUniformLocation(*Result, "offset");
-  glUseProgram(*Result);
-  glUniform4f(OffsetVertexLocation, 1.0F, 1.0F, 0.0F, 0.0F);
+  auto const GridProgram = (*Result)->Get();
+  int const OffsetVertexLocation = glGetUniformLocation(GridProgram, "offset");
 
   constexpr auto kNumOfSquaresOnChessBoard = 64UZ;
-  std::array<gl::Quadrilateral, kNumOfSquaresOnChessBoard> ListOfSquares{};
+  auto ChessBoard = gl::InstancedMesh::UnitQuad();
   auto constexpr static kCanvasWidth = 2.0F;
   auto Transform = [](auto num) -> auto {
-    auto BasePos =
-        gl::Vector3<float>{// NOLINTNEXTLINE
-                           -1.0F + 0.25F * (num % 8),
-                           // NOLINTNEXTLINE
-                           -1.0F + 0.25F * static_cast<int>(num / 8), 0.0F};
-
-    auto RGBValue = 0.0F;
-
     auto constexpr static kWidth = 8Z;
+    auto RGBValue = 0.0F;
     if ((num + num / kWidth) % 2 == 0) {
       RGBValue = 1.0F;
-    } else {
     }
-    auto Color = gl::ColorFloat{
-        .red = {RGBValue}, .blue = {RGBValue}, .green = {RGBValue}};
-    return gl::Quadrilateral(std::array{
-        gl::Point{.m_Position{BasePos}, .m_Color{Color}},
-        gl::Point{
-            .m_Position = {(BasePos + gl::Vector3<float>{kCanvasWidth / kWidth,
-                                                         0.0F, 0.0F})},
-            .m_Color{Color}},
-        gl::Point{
-            .m_Position = {(BasePos + gl::Vector3<float>{kCanvasWidth / kWidth,
-                                                         kCanvasWidth / kWidth,
-                                                         0.0F})},
-            .m_Color{Color}},
-        gl::Point{.m_Position = {(
-                      BasePos +
-                      gl::Vector3<float>{0.0F, kCanvasWidth / kWidth, 0.0F})},
-                  .m_Color{Color}}});
+    return gl::InstanceData{
+        .m_Offset = {{// NOLINTNEXTLINE
+                      -1.0F + 0.25F * (num % 8),
+                      // NOLINTNEXTLINE
+                      -1.0F + 0.25F * static_cast<int>(num / 8), 0.0F, 0.0F}},
+        .m_Scale = {{kCanvasWidth / kWidth, kCanvasWidth / kWidth}},
+        .m_Color = {
+            .red = {RGBValue}, .blue = {RGBValue}, .green = {RGBValue}}};
   };
-  for (auto&& [Num, Square] : ListOfSquares | std::views::enumerate) {
-    Square = Transform(Num);
+  std::vector<gl::InstanceData> Squares(kNumOfSquaresOnChessBoard);
+  {
+    // the per-frame work is too small to split, so the workers only live
+    // through the board setup
+    gl::JobSystem Jobs;
+    Jobs.ParallelFor(0, Squares.size(),
+                     [&](std::size_t first, std::size_t last) {
+                       for (auto Num = first; Num < last; ++Num) {
+                         Squares[Num] =
+                             Transform(static_cast<std::ptrdiff_t>(Num));
+                       }
+                     });
+  }
+  for (auto const& Square : Squares) {
+    ChessBoard.Add(Square);
   }
 
   gl::DrawerClass ClearDrawer(
@@ -165,64 +275,199 @@ auto main() -> int {
         glClearColor(0.2F, 0.3F, 0.3F, 1.0F);
         glClear(GL_COLOR_BUFFER_BIT);
       });
+  // the update stage fills the packet CurrentPacket points to
+  gl::FramePacket* CurrentPacket = nullptr;
+  gl::GridMotion Motion{
+      .m_Velocity = {{kStartingScaleFactor, kStartingScaleFactor}}};
+  gl::FixedTimestep Timestep;
   gl::DrawerClass GridDrawer(
-      [&VAO, CurrentOffset = gl::Vector2<float>{0.0F, 0.0F},
-       KXScalingFactor = kStartingScaleFactor,
-       KYScalingFactor = kStartingScaleFactor, &OffsetVertexLocation](
+      [&CurrentPacket, &Motion, GridProgram,
+       GridVertexArrayId = GridVertexArray.Get().value_or(0),
+       OffsetVertexLocation](
           [[maybe_unused]] GLFWwindow const& window,
-          [[maybe_unused]] std::chrono::nanoseconds deltaTime) mutable -> void {
-        // NOLINTNEXTLINE
-        auto DeltaSec = static_cast<float>(deltaTime.count()) / 1'000'000'000;
-        CurrentOffset =
-            (gl::Vector2<float>{1.0F * KXScalingFactor * DeltaSec,
-                                1.0F * KYScalingFactor * DeltaSec}) +
-            CurrentOffset;
-        if (CurrentOffset.X() > 1.0F) {
-          CurrentOffset.X() = 2 - CurrentOffset.X();
-          KXScalingFactor *= -1;
+          [[maybe_unused]] std::chrono::nanoseconds deltaTime,
+          float alpha) -> void {
+        auto Offset = Motion.At(alpha);
+        // the grid has a translucent corner, so it is sorted back to front
+        CurrentPacket->m_Commands.push_back(gl::DrawCommand{
+            .m_Key = gl::sort_key::Translucent(0, GridProgram,
+                                               GridVertexArrayId, 0.0F),
+            .m_Program = GridProgram,
+            .m_VertexArray = GridVertexArrayId,
+            .m_Count = kNumOfVert,
+            .m_UniformLocation = OffsetVertexLocation,
+            .m_Uniform = {Offset.X(), Offset.Y(), 0.0F, 0.0F}});
+      });
+  auto& Profiler = gl::Profiler::Instance();
+  auto& Stats = gl::FrameStats::Instance();
+  Stats.SetLogInterval(gl::kProfileReportFrames, spdlog::level::debug);
+  gl::TraceExporter Trace{"shape-trace.json"};
+  gl::TraceTarget.store(&Trace);
+#ifdef SIGUSR1
+  std::signal(SIGUSR1, gl::ToggleTraceOnSignal);
+#endif
+  if (auto const Frames = gl::NumberFromEnvironment("SHAPE_TRACE_FRAMES");
+      Frames != 0) {
+    if (auto Started = Trace.Start(Frames); !Started) {
+      Started.error().Handle();
+    }
+  }
+
+  // Update runs on this thread next to the event loop, Submit on the render
+  // thread, which owns the context from here on; with a depth of two frame
+  // N+1 is updated while frame N is submitted. Update simulates in fixed
+  // steps of the steady_clock frame time and draws interpolated.
+  auto const Depth = gl::NumberFromEnvironment("SHAPE_PIPELINE_DEPTH");
+  gl::FramePipeline<gl::FramePacket> Pipeline{
+      Depth != 0 ? Depth : gl::kPipelineDepth};
+  auto Frame = 0ULL;
+  auto const Update = Pipeline.AddStage(
+      "Update",
+      [&](gl::FramePacket& packet, std::chrono::nanoseconds deltaTime) {
+        packet.Reset(Frame++, deltaTime);
+        // resizes are applied by the render thread, which owns the context
+        glfwGetFramebufferSize(Window, &packet.m_FramebufferWidth,
+                               &packet.m_FramebufferHeight);
+        packet.m_Cursor = gl::CursorPosition(*Window);
+        auto const Alpha = Timestep.Simulate(
+            deltaTime,
+            [&Motion](std::chrono::nanoseconds step) { Motion.Step(step); });
+        CurrentPacket = &packet;
+        GridDrawer.Draw(*Window, deltaTime, Alpha);
+        CurrentPacket = nullptr;
+      },
+      gl::FramePipeline<gl::FramePacket>::Runner::kCaller);
+  gl::RenderQueue Queue;
+  auto const FramesInFlight =
+      gl::NumberFromEnvironment("SHAPE_FRAMES_IN_FLIGHT");
+  gl::FrameFences Fences{FramesInFlight != 0 ? FramesInFlight
+                                             : gl::kFramesInFlight};
+  // the chessboard square under the cursor, drawn through a quad batch
+  gl::QuadBatch Highlights;
+  constexpr auto kHighlightColor = gl::ColorFloat{
+      .red = {1.0F}, .blue = {0.0F}, .green = {0.8F}, .alpha = {0.35F}};
+  constexpr auto kCorner = -1.0F + gl::kSquareSize;
+  gl::Quadrilateral Highlight{
+      Highlights,
+      std::array{
+          gl::Point{.m_Position = {{-1.0F, -1.0F, 0.0F}},
+                    .m_Color = kHighlightColor},
+          gl::Point{.m_Position = {{kCorner, -1.0F, 0.0F}},
+                    .m_Color = kHighlightColor},
+          gl::Point{.m_Position = {{kCorner, kCorner, 0.0F}},
+                    .m_Color = kHighlightColor},
+          gl::Point{.m_Position = {{-1.0F, kCorner, 0.0F}},
+                    .m_Color = kHighlightColor}}};
+  auto HoveredSquare = 0UZ;
+  auto ViewportWidth = static_cast<int>(gl::kStartingWidth);
+  auto ViewportHeight = static_cast<int>(gl::kStartingHeight);
+  auto const Submit = Pipeline.AddStage(
+      "Submit",
+      [&](gl::FramePacket& packet, std::chrono::nanoseconds deltaTime) {
+        Profiler.BeginFrame();
+        {
+          gl::CpuScope const GpuWait{"WaitForGpu"};
+          Fences.Wait();
         }
-        if (CurrentOffset.X() < 0.0F) {
-          CurrentOffset.X() = -CurrentOffset.X();
-          KXScalingFactor *= -1;
+        gl::GpuScope const SubmitGpu{"Submit"};
+        if (packet.m_FramebufferWidth != ViewportWidth ||
+            packet.m_FramebufferHeight != ViewportHeight) {
+          ViewportWidth = packet.m_FramebufferWidth;
+          ViewportHeight = packet.m_FramebufferHeight;
+          glViewport(0, 0, ViewportWidth, ViewportHeight);
         }
-        // NOLINTNEXTLINE
-        if (CurrentOffset.Y() > 1.7F) {
-          // NOLINTNEXTLINE
-          CurrentOffset.Y() = 3.4F - CurrentOffset.Y();
-          KYScalingFactor *= -1;
+        // Clear screen
+        ClearDrawer.Draw(*Window, deltaTime);
+        ChessBoard.Enqueue(Queue);
+        if (auto const Square = gl::SquareAt(packet.m_Cursor)) {
+          if (*Square != HoveredSquare) {
+            HoveredSquare = *Square;
+            auto const Column = *Square % gl::kBoardWidth;
+            auto const Row = *Square / gl::kBoardWidth;
+            Highlight.SetOffset(gl::Vector4<float>{
+                {gl::kSquareSize * static_cast<float>(Column),
+                 gl::kSquareSize * static_cast<float>(Row), 0.0F, 0.0F}});
+          }
+          Highlights.Enqueue(Queue, 0, true);
         }
-        if (CurrentOffset.Y() < 0.0F) {
-          CurrentOffset.Y() = -CurrentOffset.Y();
-          KYScalingFactor *= -1;
+        for (auto const& Command : packet.m_Commands) {
+          Queue.Submit(Command);
         }
-        glUniform4f(OffsetVertexLocation, CurrentOffset.X(), CurrentOffset.Y(),
-                    0.0F, 0.0F);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, kNumOfVert, GL_UNSIGNED_INT, nullptr);
-      });
-  auto PreviousTime = std::chrono::system_clock::now();
-  // Main loop
+        Queue.Flush();
+      },
+      gl::FramePipeline<gl::FramePacket>::Runner::kCaller);
+  Pipeline.Start();
+
+  glfwMakeContextCurrent(nullptr);
+  auto const TargetRate = gl::NumberFromEnvironment("SHAPE_TARGET_FPS");
+  gl::FramePacer Pacer{static_cast<double>(TargetRate)};
+  std::thread RenderThread{[&] {
+    glfwMakeContextCurrent(Window);
+    if (TargetRate != 0) {
+      // the pacer sets the rate, vsync would only queue frames behind it
+      glfwSwapInterval(0);
+    }
+    while (Pipeline.RunStage(Submit)) {
+      {
+        gl::CpuScope const Swap{"SwapBuffers"};
+        glfwSwapBuffers(Window);
+      }
+      Fences.EndFrame();
+      Profiler.EndFrame();
+      Stats.EndFrame();
+      auto const& Calls = Stats.Last();
+      auto const Counters = std::array{
+          gl::TraceCounter{"Draw calls",
+                           static_cast<double>(Calls.m_DrawCalls)},
+          gl::TraceCounter{"Triangles", static_cast<double>(Calls.m_Triangles)},
+          gl::TraceCounter{"Program switches",
+                           static_cast<double>(Calls.m_ProgramSwitches)},
+          gl::TraceCounter{"Vertex array binds",
+                           static_cast<double>(Calls.m_VertexArrayBinds)},
+          gl::TraceCounter{"Uniform updates",
+                           static_cast<double>(Calls.m_UniformUpdates)},
+          gl::TraceCounter{"Uploaded bytes",
+                           static_cast<double>(Calls.m_UploadedBytes)}};
+      Trace.Frame(Profiler, Counters);
+      if (Profiler.Frames() % gl::kProfileReportFrames == 0) {
+        Profiler.LogSummary(spdlog::level::debug);
+        for (auto It = 0UZ; It < Pipeline.StageCount(); ++It) {
+          auto const Timing = Pipeline.Timing(It);
+          spdlog::debug(
+              "stage {:<18} last {:7.3f} ms  avg {:7.3f} ms  ({} frames)",
+              Timing.m_Name,
+              std::chrono::duration<double, std::milli>{Timing.m_Last}.count(),
+              std::chrono::duration<double, std::milli>{Timing.m_Average}
+                  .count(),
+              Timing.m_Frames);
+        }
+      }
+    }
+    Trace.Stop();
+    Profiler.ReleaseGpu();
+    glfwMakeContextCurrent(nullptr);
+  }};
+
+  // Main loop: events and the update stage, which blocks once Depth frames
+  // wait for the render thread. Events are polled after the pacing wait, so
+  // the update sees the latest input; SHAPE_PIPELINE_DEPTH=1 also submits
+  // that frame before the next one is updated.
+  auto TraceKeyWasDown = false;
   while (glfwWindowShouldClose(Window) == 0) {
-    auto const StartTime = std::chrono::system_clock::now();
-    std::chrono::nanoseconds const DeltaTimeNano = StartTime - PreviousTime;
-    PreviousTime = StartTime;
-    // Clear screen
-    ClearDrawer.Draw(*Window, DeltaTimeNano);
-    std::ranges::for_each(ListOfSquares,
-                          [DeltaTimeNano](gl::Quadrilateral& val) -> void {
-                            val.Draw(DeltaTimeNano);
-                          });
-    GridDrawer.Draw(*Window, DeltaTimeNano);
-
-    // Swap buffers and poll events
-    glfwSwapBuffers(Window);
+    Pacer.WaitForNextFrame();
     glfwPollEvents();
+    auto const TraceKeyDown = glfwGetKey(Window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (TraceKeyDown && !TraceKeyWasDown) {
+      Trace.RequestToggle();
+    }
+    TraceKeyWasDown = TraceKeyDown;
+    Pipeline.RunStage(Update);
   }
-  glDeleteBuffers(1, &buffer);
-  glDeleteProgram(*Result);
-  glDeleteVertexArrays(1, &VAO);
+  Pipeline.Close();
+  RenderThread.join();
+  gl::TraceTarget.store(nullptr);
+  // the GL objects of this scope are destroyed on this thread
+  glfwMakeContextCurrent(Window);
 
-  // Clean up
-  glfwTerminate();
   return 0;
 }
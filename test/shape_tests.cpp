@@ -0,0 +1,894 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <shape/ColorKernels.hpp>
+#include <shape/FixedTimestep.hpp>
+#include <shape/FramePacer.hpp>
+#include <shape/FramePacket.hpp>
+#include <shape/FramePipeline.hpp>
+#include <shape/FrameStats.hpp>
+#include <shape/HeadlessContext.hpp>
+#include <shape/InstancedMesh.hpp>
+#include <shape/JobSystem.hpp>
+#include <shape/Matrix.hpp>
+#include <shape/MeshArena.hpp>
+#include <shape/PackedVertex.hpp>
+#include <shape/Profiler.hpp>
+#include <shape/QuadBatch.hpp>
+#include <shape/RecordingBackend.hpp>
+#include <shape/RenderQueue.hpp>
+#include <shape/ShaderCache.hpp>
+#include <shape/StateCache.hpp>
+#include <shape/StreamingRingBuffer.hpp>
+#include <shape/TraceExporter.hpp>
+#include <shape/VectorKernels.hpp>
+#include <shape/VertexStream.hpp>
+#include <span>
+#include <vector>
+
+namespace {
+auto MakeQuad(float x, float y) -> std::array<gl::Point, 4> {
+  return {gl::Point{.m_Position{{x, y, 0.0F}}},
+          gl::Point{.m_Position{{x + 0.1F, y, 0.0F}}},
+          gl::Point{.m_Position{{x + 0.1F, y + 0.1F, 0.0F}}},
+          gl::Point{.m_Position{{x, y + 0.1F, 0.0F}}}};
+}
+
+// Runs every Vector operation that has a SIMD path at run time and compares
+// it with the same operation evaluated by the compiler, which always takes the
+// scalar loops. Inputs are small dyadic values, so both paths are exact and
+// fused or reordered arithmetic cannot explain a mismatch.
+template <auto kLhs, auto kRhs, auto kAddend>
+void CheckVectorPaths() {
+  constexpr auto kDot = gl::Dot(kLhs, kRhs);
+  constexpr auto kDifference = kLhs - kRhs;
+  constexpr auto kMin = gl::Min(kLhs, kRhs);
+  constexpr auto kMax = gl::Max(kLhs, kRhs);
+  constexpr auto kMultiplyAdd = gl::MultiplyAdd(kLhs, kRhs, kAddend);
+  // a neighbour with large values shows a load that reads past three lanes
+  std::vector Storage{kLhs, kRhs, kAddend, decltype(kLhs){}};
+  std::ranges::fill(Storage.back().m_Values, 1024.0F);
+  auto const& Lhs = Storage[0];
+  auto const& Rhs = Storage[1];
+  auto const& Addend = Storage[2];
+  REQUIRE(gl::Dot(Lhs, Rhs) == kDot);
+  REQUIRE((Lhs - Rhs).m_Values == kDifference.m_Values);
+  REQUIRE(gl::Min(Lhs, Rhs).m_Values == kMin.m_Values);
+  REQUIRE(gl::Max(Lhs, Rhs).m_Values == kMax.m_Values);
+  REQUIRE(gl::MultiplyAdd(Lhs, Rhs, Addend).m_Values == kMultiplyAdd.m_Values);
+  if constexpr (kLhs.m_Values.size() == 3) {
+    constexpr auto kCross = gl::Cross(kLhs, kRhs);
+    REQUIRE(gl::Cross(Lhs, Rhs).m_Values == kCross.m_Values);
+  }
+  // Length and Normalize are not constexpr; check them against std::sqrt of
+  // the scalar dot product instead
+  auto const Length = std::sqrt(gl::Dot(kAddend, kAddend));
+  REQUIRE(gl::Length(Addend) == Length);
+  auto const Normalized = gl::Normalize(Addend);
+  for (auto It = 0UZ; It < kAddend.m_Values.size(); ++It) {
+    REQUIRE(std::abs(Normalized.m_Values[It] -
+                     (kAddend.m_Values[It] / Length)) < 1e-6F);
+  }
+}
+
+template <std::size_t Rows, std::size_t Columns>
+auto IsNear(gl::Matrix<float, Rows, Columns> const& lhs,
+            gl::Matrix<float, Rows, Columns> const& rhs) -> bool {
+  for (auto Column = 0UZ; Column < Columns; ++Column) {
+    for (auto Row = 0UZ; Row < Rows; ++Row) {
+      if (std::abs(lhs.At(Row, Column) - rhs.At(Row, Column)) > 1e-5F) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST_CASE("A quad batch costs one draw call per material", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  gl::QuadBatch Batch;
+  auto const First = Batch.Add(MakeQuad(0.0F, 0.0F));
+  for (auto It = 1; It < 100; ++It) {
+    Batch.Add(MakeQuad(static_cast<float>(It) * 0.01F, 0.0F));
+  }
+  Batch.Draw();
+  REQUIRE(Backend.Log().DrawCalls() == 1);
+
+  Backend.Log().Clear();
+  Batch.Draw();
+  REQUIRE(Backend.Log().DrawCalls() == 1);
+  REQUIRE(Backend.Log().UploadBytes() == 0);
+  REQUIRE(Backend.Log().Count("glUseProgram") == 0);
+
+  Backend.Log().Clear();
+  Batch.SetOffset(First, gl::Vector4<float>{{0.5F, 0.0F, 0.0F, 0.0F}});
+  Batch.Draw();
+  REQUIRE(Backend.Log().UploadBytes() == 4 * sizeof(gl::Vector3<float>));
+
+  // a removed quad's id is reused, its old handle stays stale
+  REQUIRE(Batch.Remove(First));
+  REQUIRE_FALSE(Batch.Remove(First));
+  auto const Reused = Batch.Add(MakeQuad(0.0F, 0.5F));
+  REQUIRE(Reused.m_Quad == First.m_Quad);
+  REQUIRE_FALSE(Batch.Contains(First));
+  REQUIRE_THROWS_AS(Batch.SetOffset(First, {}), std::invalid_argument);
+  REQUIRE(Batch.Size() == 100);
+}
+
+TEST_CASE("Instanced meshes upload only the instances that changed",
+          "[recording]")
+{
+  gl::RecordingBackend Backend;
+  auto Mesh = gl::InstancedMesh::UnitQuad();
+  constexpr auto kInstances = 10UZ;
+  for (auto It = 0UZ; It < kInstances; ++It) {
+    auto const X = static_cast<float>(It) * 0.1F;
+    Mesh.Add({.m_Offset = {{X, 0.0F, 0.0F, 0.0F}}});
+  }
+  Backend.Log().Clear();
+  Mesh.Draw();
+  REQUIRE(Backend.Log().DrawCalls() == 1);
+  auto const* Draw = Backend.Log().Last("glDrawElementsInstanced");
+  REQUIRE(Draw != nullptr);
+  REQUIRE(Draw->m_Args[4] == static_cast<std::int64_t>(kInstances));
+  REQUIRE(Backend.Log().UploadBytes() ==
+          kInstances * sizeof(gl::InstanceData));
+
+  Backend.Log().Clear();
+  Mesh.Set(3, {.m_Offset = {{0.0F, 0.5F, 0.0F, 0.0F}}});
+  Mesh.Draw();
+  REQUIRE(Backend.Log().UploadBytes() == sizeof(gl::InstanceData));
+  REQUIRE(Backend.Log().Last("glNamedBufferSubData")->m_Args[1] ==
+          static_cast<std::int64_t>(3 * sizeof(gl::InstanceData)));
+
+  Backend.Log().Clear();
+  Mesh.Draw();
+  REQUIRE(Backend.Log().DrawCalls() == 1);
+  REQUIRE(Backend.Log().UploadBytes() == 0);
+}
+
+TEST_CASE("Identical shader sources share one program", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  auto& Cache = gl::ShaderCache::Instance();
+  Cache.ResetStats();
+  static constexpr auto kDefines =
+      std::array{std::string_view{"SHARED_PROGRAM_TEST"}};
+  static constexpr auto kOtherDefines =
+      std::array{std::string_view{"OTHER_PROGRAM_TEST"}};
+  auto Link = [&Cache](std::span<std::string_view const> defines) {
+    auto Program = Cache.Get(gl::kDefaultVertexShader,
+                             gl::kDefaultFragmentShader, defines);
+    REQUIRE(Program.has_value());
+    return *std::move(Program);
+  };
+  {
+    auto const First = Link(kDefines);
+    auto const Second = Link(kDefines);
+    REQUIRE(First == Second);
+    REQUIRE(Backend.Log().Count("glLinkProgram") == 1);
+    REQUIRE(Cache.GetStats().m_Hits == 1);
+    REQUIRE(Cache.GetStats().m_Misses == 1);
+
+    auto const Other = Link(kOtherDefines);
+    REQUIRE(Other->Get() != First->Get());
+    REQUIRE(Other->Key() != First->Key());
+    REQUIRE(Backend.Log().Count("glLinkProgram") == 2);
+  }
+  // the last handles are gone, so the next request links again
+  REQUIRE(Backend.Log().Count("glDeleteProgram") == 2);
+  Backend.Log().Clear();
+  auto const Relinked = Link(kDefines);
+  REQUIRE(Backend.Log().Count("glLinkProgram") == 1);
+  REQUIRE(Cache.GetStats().m_Misses == 3);
+  Cache.Purge();
+  Cache.ResetStats();
+}
+
+TEST_CASE("Frame statistics count what a frame issues", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  auto& Stats = gl::FrameStats::Instance();
+  gl::QuadBatch Batch;
+  for (auto It = 0; It < 100; ++It) {
+    Batch.Add(MakeQuad(static_cast<float>(It) * 0.01F, 0.0F));
+  }
+  Stats.Reset();
+  Backend.Log().Clear();
+  Batch.Draw();
+  Batch.Draw();
+  Stats.EndFrame();
+  auto const& Frame = Stats.Last();
+  REQUIRE(Frame.m_DrawCalls == 2);
+  REQUIRE(Frame.m_Triangles == 400);
+  REQUIRE(Frame.m_ProgramSwitches == 1);
+  REQUIRE(Frame.m_VertexArrayBinds == 1);
+  REQUIRE(Frame.m_UploadedBytes == Backend.Log().UploadBytes());
+  REQUIRE(Frame.m_BufferUploads != 0);
+  REQUIRE(Stats.Current() == gl::FrameCounters{});
+
+  Batch.Draw();
+  Stats.EndFrame();
+  REQUIRE(Stats.Last().m_UploadedBytes == 0);
+  REQUIRE(Stats.Total().m_DrawCalls == 3);
+  REQUIRE(Stats.Frames() == 2);
+}
+
+TEST_CASE("Element array binds are issued for every vertex array",
+          "[recording]")
+{
+  gl::RecordingBackend Backend;
+  auto& State = gl::StateCache::Instance();
+  State.Invalidate();
+  State.BindBuffer(GL_ARRAY_BUFFER, 7);
+  State.BindBuffer(GL_ARRAY_BUFFER, 7);
+  REQUIRE(Backend.Log().Count("glBindBuffer") == 1);
+  State.BindVertexArray(1);
+  State.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+  State.BindVertexArray(2);
+  State.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+  REQUIRE(Backend.Log().Count("glBindBuffer") == 3);
+  State.Invalidate();
+}
+
+TEST_CASE("Vertex streams set up their own attribute formats", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  gl::VertexStream<gl::Vector3<float>, gl::ColorFloat> Stream{
+      gl::Interleaving::kInterleaved, {0U, 1U}};
+  REQUIRE(Stream.Layout().Stride() == 28);
+  REQUIRE(Backend.Log().Last("glVertexArrayAttribFormat")->m_Args.at(5) == 12);
+  REQUIRE(Backend.Log().Count("glVertexArrayVertexBuffer") == 1);
+
+  Stream.Resize(8);
+  Stream.Upload();
+  Backend.Log().Clear();
+  Stream.Set<1>(3, gl::ColorFloat{.red{1.0F}});
+  Stream.Upload();
+  // interleaved vertices go up whole
+  REQUIRE(Backend.Log().UploadBytes() == 28);
+  REQUIRE(Backend.Log().Last("glNamedBufferSubData")->m_Args.at(1) == 3 * 28);
+}
+
+TEST_CASE("The render queue draws translucent commands last", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  gl::RenderQueue Queue;
+  Queue.Submit({.m_Key = gl::sort_key::Translucent(0, 1, 1, 0.5F),
+                .m_Program = 1,
+                .m_VertexArray = 1,
+                .m_Count = 3});
+  Queue.Submit({.m_Key = gl::sort_key::Opaque(0, 2, 2, 0.5F),
+                .m_Program = 2,
+                .m_VertexArray = 2,
+                .m_Count = 6});
+  Queue.Submit({.m_Key = gl::sort_key::Opaque(0, 2, 2, 0.1F),
+                .m_Program = 2,
+                .m_VertexArray = 2,
+                .m_Count = 9});
+  Queue.Flush();
+
+  auto const& Log = Backend.Log();
+  REQUIRE(Log.DrawCalls() == 3);
+  REQUIRE(Log.Count("glUseProgram") == 2);
+  REQUIRE(Log.Count("glBindVertexArray") == 2);
+  REQUIRE(Log.Last("glDrawElementsBaseVertex")->m_Args.at(1) == 3);
+  REQUIRE(Log.Last("glEnable")->m_Args.at(0) == GL_BLEND);
+  REQUIRE(Queue.Size() == 0);
+
+  REQUIRE(gl::sort_key::QuantizeDepth(
+              std::numeric_limits<float>::quiet_NaN()) == 0);
+  REQUIRE(gl::sort_key::QuantizeDepth(2.0F) == gl::sort_key::kDepthMask);
+  REQUIRE(gl::sort_key::Opaque(15, 1, 1, 0.0F) >
+          gl::sort_key::Translucent(14, 1, 1, 0.0F));
+}
+
+TEST_CASE("A mesh arena draws every mesh with one indirect call", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  gl::MeshArena Arena;
+  constexpr auto kIndices = std::array<GLuint, 6>{0U, 1U, 2U, 0U, 2U, 3U};
+  for (auto It = 0; It < 50; ++It) {
+    auto const Quad = MakeQuad(0.0F, static_cast<float>(It) * 0.01F);
+    Arena.Add(Quad, kIndices);
+  }
+  Arena.Draw();
+  REQUIRE(Backend.Log().DrawCalls() == 1);
+  REQUIRE(Backend.Log().Count("glMultiDrawElementsIndirect") == 1);
+
+  Backend.Log().Clear();
+  Arena.SetVisible(7, false);
+  Arena.Draw();
+  REQUIRE(Backend.Log().UploadBytes() ==
+          50 * sizeof(gl::DrawElementsIndirectCommand));
+  REQUIRE(Arena.Commands()[7].m_InstanceCount == 0);
+}
+
+TEST_CASE("Ring buffer writes land in the mapped storage", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  gl::StreamingRingBuffer<float> Ring(4, 2);
+  REQUIRE(Ring.BeginFrame().has_value());
+  auto Block = Ring.Allocate(3);
+  REQUIRE(Block.has_value());
+  Block->m_Data[0] = 1.0F;
+  Block->m_Data[2] = 3.0F;
+  REQUIRE_FALSE(Ring.Allocate(2).has_value());
+  Ring.EndFrame();
+
+  auto const Contents = Backend.BufferContents(Ring.Get());
+  REQUIRE(Contents.size() == 8 * sizeof(float));
+  float Written = 0.0F;
+  std::memcpy(&Written,
+              Contents.data() + ((Block->m_FirstElement + 2) * sizeof(float)),
+              sizeof(float));
+  REQUIRE(Written == 3.0F);
+  REQUIRE(Backend.Log().Count("glFenceSync") == 1);
+  // a second fence for the same frame replaces the first one
+  Ring.EndFrame();
+  REQUIRE(Backend.Log().Count("glDeleteSync") == 1);
+
+  REQUIRE_THROWS_AS(gl::StreamingRingBuffer<float>(0, 2),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(gl::StreamingRingBuffer<float>(4, 0),
+                    std::invalid_argument);
+  // a driver that refuses the mapping fails every frame instead of crashing
+  auto* const Map = glad_glMapNamedBufferRange;
+  glad_glMapNamedBufferRange = [](GLuint /*buffer*/, GLintptr /*offset*/,
+                                  GLsizeiptr /*length*/,
+                                  GLbitfield /*access*/) -> void* {
+    return nullptr;
+  };
+  gl::StreamingRingBuffer<float> Unmapped(4, 2);
+  glad_glMapNamedBufferRange = Map;
+  REQUIRE_FALSE(Unmapped.BeginFrame().has_value());
+  REQUIRE_FALSE(Unmapped.Allocate(1).has_value());
+}
+
+TEST_CASE("Frame fences wait for the frame FramesInFlight back", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  {
+    gl::FrameFences Fences{2};
+    for (auto Frame = 0; Frame < 5; ++Frame) {
+      Fences.Wait();
+      Fences.EndFrame();
+    }
+    REQUIRE(Backend.Log().Count("glFenceSync") == 5);
+    REQUIRE(Backend.Log().Count("glClientWaitSync") == 3);
+    REQUIRE(Backend.Log().Count("glDeleteSync") == 3);
+    REQUIRE(Fences.Stalls() == 0);
+  }
+  REQUIRE(Backend.Log().Count("glDeleteSync") == 5);
+
+  gl::FramePacer Pacer{1000.0};
+  auto const Start = gl::FramePacer::Clock::now();
+  for (auto Frame = 0; Frame < 11; ++Frame) {
+    Pacer.WaitForNextFrame();
+  }
+  // the first frame starts the schedule, ten intervals follow
+  REQUIRE(gl::FramePacer::Clock::now() - Start >=
+          std::chrono::milliseconds{10});
+}
+
+TEST_CASE("The profiler reads GPU scopes one frame late", "[recording]")
+{
+  gl::RecordingBackend Backend;
+  auto& Profiler = gl::Profiler::Instance();
+  Profiler.Reset();
+  for (auto Frame = 0; Frame < 3; ++Frame) {
+    Profiler.BeginFrame();
+    {
+      gl::CpuScope const Work{"Work"};
+      gl::GpuScope const Draw{"Draw"};
+      gl::GpuScope const Nested{"Nested"};
+    }
+    std::thread([] { gl::CpuScope const Worker{"Worker"}; }).join();
+    Profiler.EndFrame();
+  }
+  REQUIRE(Profiler.Frames() == 3);
+  REQUIRE(Profiler.Stats("Work")->m_Frames == 3);
+  REQUIRE(Profiler.Stats("Worker")->m_Frames == 3);
+  REQUIRE(Profiler.Stats("Draw", gl::SampleKind::kGpu)->m_Frames == 2);
+  REQUIRE_FALSE(Profiler.Stats("Nested", gl::SampleKind::kGpu).has_value());
+  REQUIRE(Backend.Log().Count("glBeginQuery") == 3);
+  auto const Frame = *Profiler.Stats(gl::Profiler::kFrameScope);
+  REQUIRE(Frame.m_MinMs <= Frame.m_AvgMs);
+  REQUIRE(Frame.m_AvgMs <= Frame.m_P99Ms);
+  Profiler.ReleaseGpu();
+}
+
+TEST_CASE("Trace captures stop after their frame count", "[profiler]")
+{
+  auto const Path =
+      std::filesystem::temp_directory_path() / "shape_tests_trace.json";
+  auto& Profiler = gl::Profiler::Instance();
+  gl::TraceExporter Trace{Path};
+  REQUIRE(Trace.Start(2).has_value());
+  constexpr auto kCounters = std::array{gl::TraceCounter{"Draw calls", 3.0}};
+  for (auto Frame = 0; Frame < 3; ++Frame) {
+    Profiler.BeginFrame();
+    {
+      gl::CpuScope const Work{"Quoted \"work\""};
+    }
+    Profiler.EndFrame();
+    Trace.Frame(Profiler, kCounters);
+  }
+  REQUIRE_FALSE(Trace.IsCapturing());
+
+  std::ifstream File{Path};
+  std::string const Json{std::istreambuf_iterator<char>{File}, {}};
+  REQUIRE(Json.starts_with("{\"displayTimeUnit\""));
+  REQUIRE(Json.ends_with("]}\n"));
+  REQUIRE(Json.find("Quoted \\\"work\\\"") != std::string::npos);
+  REQUIRE(Json.find("\"ph\":\"C\"") != std::string::npos);
+  std::filesystem::remove(Path);
+}
+
+TEST_CASE("Trace files stay valid when chunks are dropped", "[profiler]")
+{
+  auto const Path =
+      std::filesystem::temp_directory_path() / "shape_tests_dropped_trace.json";
+  auto& Profiler = gl::Profiler::Instance();
+  // with no room for pending chunks every full chunk is dropped
+  gl::TraceExporter Trace{Path, 0};
+  REQUIRE(Trace.Start().has_value());
+  std::string const LongName(1000, 'x');
+  std::vector<gl::TraceCounter> const Counters(
+      100, gl::TraceCounter{.m_Name = LongName, .m_Value = 1.0});
+  for (auto Frame = 0; Frame < 3; ++Frame) {
+    Profiler.BeginFrame();
+    {
+      gl::CpuScope const Work{"Work"};
+    }
+    Profiler.EndFrame();
+    Trace.Frame(Profiler, Counters);
+  }
+  Trace.Stop();
+  REQUIRE(Trace.DroppedChunks() > 0);
+
+  // one event per line, each of them whole
+  std::ifstream File{Path};
+  std::vector<std::string> Lines;
+  for (std::string Line; std::getline(File, Line);) {
+    Lines.push_back(Line);
+  }
+  REQUIRE(Lines.size() > 2);
+  REQUIRE(Lines.front() == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  REQUIRE(Lines.back() == "]}");
+  for (auto It = 1UZ; It + 1 < Lines.size(); ++It) {
+    auto const& Event = Lines[It];
+    REQUIRE(Event.starts_with("{\"name\":"));
+    REQUIRE(Event.ends_with(It + 2 == Lines.size() ? "}" : "},"));
+    REQUIRE(std::ranges::count(Event, '{') == std::ranges::count(Event, '}'));
+  }
+  std::filesystem::remove(Path);
+}
+
+TEST_CASE("Jobs run after the counters they depend on", "[jobs]")
+{
+  gl::JobSystem Jobs{3};
+  std::vector<std::uint64_t> Values(100'000);
+  Jobs.ParallelFor(0, Values.size(), [&](std::size_t first, std::size_t last) {
+    for (auto It = first; It < last; ++It) {
+      Values[It] = It;
+    }
+  });
+  REQUIRE(Values.back() == Values.size() - 1);
+
+  std::atomic<std::uint64_t> Sum{0};
+  std::atomic<std::uint64_t> SeenByFollowUp{0};
+  gl::JobCounter Summed;
+  gl::JobCounter FollowedUp;
+  for (auto Chunk = 0UZ; Chunk < 10; ++Chunk) {
+    Jobs.Submit(
+        [&, Chunk] {
+          auto Part = 0ULL;
+          for (auto It = Chunk * 10'000; It < (Chunk + 1) * 10'000; ++It) {
+            Part += Values[It];
+          }
+          Sum.fetch_add(Part);
+        },
+        &Summed);
+  }
+  Jobs.Submit([&] { SeenByFollowUp = Sum.load(); }, &FollowedUp, &Summed);
+  Jobs.Wait(FollowedUp);
+  REQUIRE(Summed.IsDone());
+  REQUIRE(SeenByFollowUp == 99'999ULL * 100'000 / 2);
+}
+
+TEST_CASE("Pipeline stages see every frame in order, at most Depth in flight",
+          "[jobs]")
+{
+  constexpr auto kFrames = 5'000ULL;
+  constexpr auto kDepth = 3UZ;
+  using Pipeline = gl::FramePipeline<gl::FramePacket>;
+  Pipeline Stages{kDepth};
+  std::atomic<std::uint64_t> Submitted{0};
+  auto Produced = 0ULL;
+  auto MaxInFlight = 0ULL;
+  auto const Update = Stages.AddStage(
+      "Update",
+      [&](gl::FramePacket& packet, std::chrono::nanoseconds deltaTime) {
+        MaxInFlight = std::max(MaxInFlight, Produced - Submitted.load());
+        packet.Reset(Produced++, deltaTime);
+      },
+      Pipeline::Runner::kCaller);
+  auto SortedInOrder = true;
+  auto Sorted = 0ULL;
+  Stages.AddStage("Sort", [&](gl::FramePacket& packet,
+                              std::chrono::nanoseconds /*deltaTime*/) {
+    SortedInOrder = SortedInOrder && packet.m_Frame == Sorted++;
+    packet.m_Commands.push_back(
+        {.m_Count = static_cast<GLsizei>(packet.m_Frame)});
+  });
+  auto SubmittedInOrder = true;
+  Stages.AddStage("Submit", [&](gl::FramePacket& packet,
+                                std::chrono::nanoseconds /*deltaTime*/) {
+    auto const Frame = Submitted.load();
+    SubmittedInOrder = SubmittedInOrder && packet.m_Frame == Frame &&
+                       packet.m_Commands.size() == 1 &&
+                       packet.m_Commands[0].m_Count ==
+                           static_cast<GLsizei>(Frame);
+    Submitted.store(Frame + 1);
+  });
+  Stages.Start();
+  for (auto Frame = 0ULL; Frame < kFrames; ++Frame) {
+    REQUIRE(Stages.RunStage(Update));
+  }
+  Stages.Close();
+  REQUIRE_FALSE(Stages.RunStage(Update));
+  // waits until the other stages drained
+  while (Stages.Timing(2).m_Frames != kFrames) {
+    std::this_thread::yield();
+  }
+  REQUIRE(SortedInOrder);
+  REQUIRE(SubmittedInOrder);
+  REQUIRE(MaxInFlight < kDepth);
+  REQUIRE(Submitted.load() == kFrames);
+  REQUIRE(Stages.Timing(1).m_Frames == kFrames);
+}
+
+TEST_CASE("Fixed timestep runs whole steps and caps slow frames", "[timing]")
+{
+  using std::chrono::milliseconds;
+  gl::FixedTimestep Timestep{milliseconds{10}, 4};
+  auto const Short = Timestep.Advance(milliseconds{25});
+  REQUIRE(Short.m_Steps == 2);
+  REQUIRE(Short.m_Alpha == 0.5F);
+  // the leftover 5 ms count towards the next frame
+  REQUIRE(Timestep.Advance(milliseconds{5}).m_Steps == 1);
+  auto Steps = 0U;
+  auto const Alpha = Timestep.Simulate(
+      milliseconds{1000}, [&Steps](std::chrono::nanoseconds step) {
+        Steps += step == milliseconds{10} ? 1U : 0U;
+      });
+  REQUIRE(Steps == 4);
+  REQUIRE(Alpha == 0.0F);
+  REQUIRE(Timestep.Dropped() == milliseconds{960});
+  REQUIRE(Timestep.Advance(milliseconds{-5}).m_Steps == 0);
+}
+
+TEST_CASE("Vector SIMD paths match the constexpr ones", "[kernels]")
+{
+  CheckVectorPaths<gl::Vector3<float>{{1.5F, -2.0F, 3.25F}},
+                   gl::Vector3<float>{{-0.5F, 4.0F, 0.75F}},
+                   gl::Vector3<float>{{3.0F, 0.0F, -4.0F}}>();
+  CheckVectorPaths<gl::Vector4<float>{{1.5F, -2.0F, 3.25F, 8.0F}},
+                   gl::Vector4<float>{{-0.5F, 4.0F, 0.75F, -0.125F}},
+                   gl::Vector4<float>{{2.0F, -4.0F, 0.0F, 4.0F}}>();
+}
+
+TEST_CASE("Matrix inverses, products and transforms", "[kernels]")
+{
+  using gl::Mat4;
+  constexpr auto kLinear =
+      gl::Mat3<float>{{gl::Vector3<float>{{2.0F, 1.0F, 0.0F}},
+                       gl::Vector3<float>{{0.0F, 3.0F, 1.0F}},
+                       gl::Vector3<float>{{1.0F, 0.0F, 4.0F}}}};
+  auto const LinearInverse = gl::Inverse(kLinear);
+  REQUIRE(LinearInverse.has_value());
+  REQUIRE(IsNear(kLinear * *LinearInverse, gl::Identity<float, 3>()));
+  REQUIRE_FALSE(gl::Inverse(gl::Mat3<float>{}).has_value());
+
+  auto const Rigid =
+      gl::Translation(gl::Vector3<float>{{1.0F, -2.0F, 3.0F}}) *
+      gl::Rotation(gl::Normalize(gl::Vector3<float>{{1.0F, 2.0F, 2.0F}}), 0.7F);
+  auto const Affine =
+      Rigid * gl::Scaling(gl::Vector3<float>{{2.0F, 0.5F, 4.0F}});
+  auto const Projection = gl::Perspective(1.0F, 1.5F, 0.1F, 100.0F);
+  for (auto const& Value : {Rigid, Affine, Projection}) {
+    auto const General = gl::Inverse(Value);
+    REQUIRE(General.has_value());
+    REQUIRE(IsNear(Value * *General, gl::Identity<float, 4>()));
+  }
+  auto const AffineInverse = gl::AffineInverse(Affine);
+  REQUIRE(AffineInverse.has_value());
+  REQUIRE(IsNear(Affine * *AffineInverse, gl::Identity<float, 4>()));
+  REQUIRE(IsNear(Rigid * gl::RigidInverse(Rigid), gl::Identity<float, 4>()));
+  REQUIRE_FALSE(gl::Inverse(Mat4<float>{}).has_value());
+
+  // the compiler takes the scalar loops, run time the SIMD ones; dyadic
+  // entries keep both exact
+  constexpr auto kLhs =
+      Mat4<float>{{gl::Vector4<float>{{1.0F, 2.0F, 0.5F, 0.0F}},
+                   gl::Vector4<float>{{-1.0F, 0.25F, 3.0F, 1.0F}},
+                   gl::Vector4<float>{{4.0F, 0.0F, -2.0F, 0.5F}},
+                   gl::Vector4<float>{{0.0F, 1.5F, 1.0F, 2.0F}}}};
+  constexpr auto kRhs = gl::Transpose(kLhs);
+  constexpr auto kProduct = kLhs * kRhs;
+  constexpr auto kPoint = gl::Vector4<float>{{1.0F, -2.0F, 0.5F, 1.0F}};
+  constexpr auto kTransformed = kLhs * kPoint;
+  auto const Lhs = kLhs;
+  auto const Rhs = kRhs;
+  auto const Point = kPoint;
+  for (auto Column = 0UZ; Column < 4; ++Column) {
+    REQUIRE((Lhs * Rhs).m_Columns[Column].m_Values ==
+            kProduct.m_Columns[Column].m_Values);
+  }
+  REQUIRE((Lhs * Point).m_Values == kTransformed.m_Values);
+
+  // the near and far planes land on clip z -1 and 1
+  auto const ToNdcZ = [&Projection](float depth) {
+    auto const Clip =
+        Projection * gl::Vector4<float>{{0.0F, 0.0F, -depth, 1.0F}};
+    return Clip.m_Values[2] / Clip.m_Values[3];
+  };
+  REQUIRE(std::abs(ToNdcZ(0.1F) + 1.0F) < 1e-5F);
+  REQUIRE(std::abs(ToNdcZ(100.0F) - 1.0F) < 1e-4F);
+  // the eye lands on the origin, the target straight ahead on -z
+  auto const View = gl::LookAt(gl::Vector3<float>{{3.0F, 4.0F, 0.0F}},
+                               gl::Vector3<float>{{0.0F, 0.0F, 0.0F}},
+                               gl::Vector3<float>{{0.0F, 0.0F, 1.0F}});
+  auto const Eye = View * gl::Vector4<float>{{3.0F, 4.0F, 0.0F, 1.0F}};
+  auto const Target = View * gl::Vector4<float>{{0.0F, 0.0F, 0.0F, 1.0F}};
+  for (auto It = 0UZ; It < 3; ++It) {
+    REQUIRE(std::abs(Eye.m_Values[It]) < 1e-5F);
+  }
+  REQUIRE(std::abs(Target.m_Values[0]) < 1e-5F);
+  REQUIRE(std::abs(Target.m_Values[1]) < 1e-5F);
+  REQUIRE(std::abs(Target.m_Values[2] + 5.0F) < 1e-5F);
+  REQUIRE(IsNear(View * gl::RigidInverse(View), gl::Identity<float, 4>()));
+
+  // root, child and grandchild, plus a second root
+  auto const Locals = std::array{
+      gl::Translation(gl::Vector3<float>{{1.0F, 2.0F, 3.0F}}),
+      gl::Scaling(gl::Vector3<float>{{2.0F, 2.0F, 2.0F}}),
+      gl::Translation(gl::Vector3<float>{{1.0F, 0.0F, 0.0F}}), Rigid};
+  constexpr auto kParents = std::array<std::int32_t, 4>{-1, 0, 1, -1};
+  std::array<Mat4<float>, 4> World{};
+  gl::ComposeWorldMatrices(Locals, kParents, World);
+  REQUIRE(IsNear(World[2], Locals[0] * Locals[1] * Locals[2]));
+  REQUIRE(IsNear(World[3], Rigid));
+  auto const Origin = World[2] * gl::Vector4<float>{{0.0F, 0.0F, 0.0F, 1.0F}};
+  REQUIRE(Origin.m_Values == std::array{3.0F, 2.0F, 3.0F, 1.0F});
+  constexpr auto kForward = std::array<std::int32_t, 4>{-1, 2, -1, -1};
+  REQUIRE_THROWS_AS(gl::ComposeWorldMatrices(Locals, kForward, World),
+                    std::invalid_argument);
+}
+
+TEST_CASE("Vector kernels agree on every instruction set", "[kernels]")
+{
+  // odd counts so every path also runs its scalar tail
+  std::vector<gl::Point> Expected(1001);
+  for (auto It = 0UZ; It < Expected.size(); ++It) {
+    auto const Value = static_cast<float>(It);
+    Expected[It].m_Position = gl::Vector3<float>{{Value, -Value, 0.5F}};
+    Expected[It].m_Color.alpha.val = Value;
+  }
+  auto const Source = Expected;
+  constexpr auto kMatrix = std::array{1.0F, 0.0F, 0.0F, 0.0F,  //
+                                      0.0F, 2.0F, 0.0F, 0.0F,  //
+                                      0.0F, 0.0F, 1.0F, 0.0F,  //
+                                      5.0F, 0.0F, 0.0F, 1.0F};
+  gl::ForEachIsa([&](gl::Isa /*isa*/) {
+    auto Points = Source;
+    gl::AddInPlace(std::span(Points), gl::Vector3<float>{{1.0F, 2.0F, 3.0F}});
+    gl::Scale(std::span(Points), gl::Vector3<float>{{2.0F, 2.0F, 2.0F}});
+    gl::TransformByMatrix(std::span(Points), kMatrix);
+    for (auto It = 0UZ; It < Points.size(); ++It) {
+      auto const Value = static_cast<float>(It);
+      auto const& [X, Y, Z] = Points[It].m_Position.m_Values;
+      REQUIRE(X == ((Value + 1.0F) * 2.0F) + 5.0F);
+      REQUIRE(Y == (2.0F - Value) * 4.0F);
+      REQUIRE(Z == 7.0F);
+      REQUIRE(Points[It].m_Color.alpha.val == Value);
+    }
+  });
+}
+
+TEST_CASE("Packed vertices match on every instruction set", "[kernels]")
+{
+  static_assert(gl::ToHalf(1.0F) == 0x3C00);
+  static_assert(gl::ToHalf(65520.0F) == 0x7C00);
+  static_assert(gl::ToHalf(0x1p-24F) == 0x0001);
+  static_assert(gl::FromHalf(gl::ToHalf(-0.5F)) == -0.5F);
+
+  std::vector<gl::Point> Source(333);
+  for (auto It = 0UZ; It < Source.size(); ++It) {
+    auto const Value = (static_cast<float>(It) / 100.0F) - 1.5F;
+    Source[It].m_Position = gl::Vector3<float>{{Value, Value * 0.001F, 7.0F}};
+    Source[It].m_Color = {.red{Value}, .blue{0.5F}, .green{1.0F}};
+  }
+  gl::ForEachIsa([&](gl::Isa /*isa*/) {
+    std::vector<gl::PackedPoint> Packed(Source.size());
+    std::vector<gl::Snorm16Position> Snorm(Source.size());
+    gl::Pack(Source, Packed);
+    gl::PackPositions(Source, Snorm, 0.5F);
+    for (auto It = 0UZ; It < Source.size(); ++It) {
+      auto const& [X, Y, Z] = Source[It].m_Position.m_Values;
+      auto const& Half = Packed[It].m_Position.m_Values;
+      REQUIRE(Half[0] == gl::ToHalf(X));
+      REQUIRE(Half[1] == gl::ToHalf(Y));
+      REQUIRE(gl::FromHalf(Half[2]) == 7.0F);
+      REQUIRE(Snorm[It].m_Values[0] == gl::ToSnorm16(X * 0.5F));
+      REQUIRE(Snorm[It].m_Values[2] == 32767);
+      auto const Color = Packed[It].m_Color;
+      REQUIRE(Color.red.val == gl::ToUnorm8(Source[It].m_Color.red.val));
+      REQUIRE(Color.blue.val == 128);
+      REQUIRE(Color.alpha.val == 255);
+    }
+  });
+}
+
+TEST_CASE("Color conversions are exact on every instruction set", "[kernels]")
+{
+  std::vector<gl::ColorInt> Colors(259);
+  for (auto It = 0UZ; It < Colors.size(); ++It) {
+    auto const Level = static_cast<std::uint8_t>(It);
+    Colors[It] = {.red = {Level},
+                  .blue = {static_cast<std::uint8_t>(255 - Level)},
+                  .green = {static_cast<std::uint8_t>(Level / 2)},
+                  .alpha = {255}};
+  }
+  gl::ForEachIsa([&](gl::Isa /*isa*/) {
+    std::vector<gl::ColorFloat> Floats(Colors.size());
+    std::vector<gl::ColorInt> Back(Colors.size());
+    std::vector<std::uint32_t> Rgba(Colors.size());
+    std::vector<gl::ColorFloat> FromRgba(Colors.size());
+    gl::ToColorFloat(Colors, Floats);
+    gl::ToColorInt(Floats, Back);
+    gl::PackRgba(Floats, Rgba);
+    gl::ToColorFloat(Rgba, FromRgba);
+    for (auto It = 0UZ; It < Colors.size(); ++It) {
+      REQUIRE(Floats[It].red.val ==
+              static_cast<float>(Colors[It].red.val) / 255.0F);
+      REQUIRE(Floats[It].alpha.val == 1.0F);
+      REQUIRE(Back[It].blue.val == Colors[It].blue.val);
+      REQUIRE(Rgba[It] == gl::PackRgba(Colors[It]));
+      REQUIRE(FromRgba[It].green.val == Floats[It].green.val);
+    }
+  });
+
+  for (auto Level = 0; Level < 256; ++Level) {
+    auto const Encoded = static_cast<std::uint8_t>(Level);
+    REQUIRE(gl::LinearToSrgb(gl::SrgbToLinear(Encoded)) == Encoded);
+  }
+  REQUIRE(gl::SrgbToLinear(255) == 1.0F);
+  REQUIRE(std::abs(gl::SrgbToLinear(188) - 0.5F) < 0.003F);
+}
+
+#ifdef SHAPE_HAS_HEADLESS_CONTEXT
+TEST_CASE("Program binaries are cached across links", "[headless]")
+{
+  auto Context = gl::HeadlessContext::Create();
+  if (!Context) {
+    SKIP("No EGL surfaceless platform: " << Context.error().m_Message);
+  }
+  auto const Directory =
+      std::filesystem::temp_directory_path() / "shape_tests_program_binaries";
+  std::filesystem::remove_all(Directory);
+  auto& Cache = gl::ShaderCache::Instance();
+  // a define nothing else uses keeps the in-memory cache out of the way
+  static constexpr auto kDefines =
+      std::array{std::string_view{"BINARY_CACHE_TEST"}};
+  auto Link = [&Cache, &Directory] {
+    Cache.SetBinaryCache(Directory);
+    auto Program = Cache.Get(gl::kDefaultVertexShader,
+                             gl::kDefaultFragmentShader, kDefines);
+    REQUIRE(Program.has_value());
+    return Cache.GetBinaryCache()->GetStats();
+  };
+
+  auto const Cold = Link();
+  REQUIRE(Cold.m_Missing == 1);
+  if (Cold.m_Stored == 0) {
+    Cache.SetBinaryCache(std::nullopt);
+    SKIP("The driver offers no program binary formats");
+  }
+  auto const Warm = Link();
+  REQUIRE(Warm.m_Loaded == 1);
+  REQUIRE(Warm.m_Stored == 0);
+
+  // claim a length far beyond the file, the entry must not be trusted
+  auto const Entry = std::filesystem::directory_iterator{Directory}->path();
+  {
+    std::fstream File{Entry, std::ios::binary | std::ios::in | std::ios::out};
+    constexpr auto kLengthOffset = 36;
+    constexpr auto kHugeLength = std::uint32_t{0xFFFF'FFF0U};
+    File.seekp(kLengthOffset);
+    // NOLINTNEXTLINE
+    File.write(reinterpret_cast<char const*>(&kHugeLength),
+               sizeof(kHugeLength));
+  }
+  auto const Corrupted = Link();
+  REQUIRE(Corrupted.m_Rejected == 1);
+  REQUIRE(Corrupted.m_Loaded == 0);
+  REQUIRE(Corrupted.m_Stored == 1);
+  REQUIRE(Link().m_Loaded == 1);
+
+  Cache.SetBinaryCache(std::nullopt);
+  std::filesystem::remove_all(Directory);
+}
+
+TEST_CASE("A binary cache without its directory stays off", "[headless]")
+{
+  auto Context = gl::HeadlessContext::Create();
+  if (!Context) {
+    SKIP("No EGL surfaceless platform: " << Context.error().m_Message);
+  }
+  // a directory below a regular file cannot be created
+  auto const Blocker =
+      std::filesystem::temp_directory_path() / "shape_tests_not_a_directory";
+  std::filesystem::remove_all(Blocker);
+  std::ofstream{Blocker} << "file";
+  auto& Cache = gl::ShaderCache::Instance();
+  Cache.SetBinaryCache(Blocker / "binaries");
+  static constexpr auto kDefines =
+      std::array{std::string_view{"UNCREATABLE_CACHE_TEST"}};
+  auto const Program = Cache.Get(gl::kDefaultVertexShader,
+                                 gl::kDefaultFragmentShader, kDefines);
+  REQUIRE(Program.has_value());
+  auto const Stats = Cache.GetBinaryCache()->GetStats();
+  REQUIRE(Stats.m_Missing == 0);
+  REQUIRE(Stats.m_Loaded == 0);
+  REQUIRE(Stats.m_Stored == 0);
+  REQUIRE_FALSE(std::filesystem::exists(Blocker / "binaries"));
+
+  Cache.SetBinaryCache(std::nullopt);
+  std::filesystem::remove(Blocker);
+}
+
+TEST_CASE("Recording forwards to a headless context", "[headless]")
+{
+  auto Context = gl::HeadlessContext::Create();
+  if (!Context) {
+    SKIP("No EGL surfaceless platform: " << Context.error().m_Message);
+  }
+  {
+    gl::RecordingBackend Backend(gl::RecordingBackend::Mode::kForward);
+    gl::QuadBatch Batch;
+    gl::Point Corner{.m_Color{.red{1.0F}}};
+    auto Quad = std::array{Corner, Corner, Corner, Corner};
+    Quad[0].m_Position = gl::Vector3<float>{{-1.0F, -1.0F, 0.0F}};
+    Quad[1].m_Position = gl::Vector3<float>{{1.0F, -1.0F, 0.0F}};
+    Quad[2].m_Position = gl::Vector3<float>{{1.0F, 1.0F, 0.0F}};
+    Quad[3].m_Position = gl::Vector3<float>{{-1.0F, 1.0F, 0.0F}};
+    Batch.Add(Quad);
+    glClear(GL_COLOR_BUFFER_BIT);
+    Batch.Draw();
+    REQUIRE(Backend.Log().DrawCalls() == 1);
+  }
+  auto const Pixel = Context->ReadPixel(Context->Width() / 2,
+                                        Context->Height() / 2);
+  REQUIRE(Pixel[0] == 255);
+  REQUIRE(Pixel[1] == 0);
+}
+#endif